@@ -0,0 +1,149 @@
+#include <iostream>			// std::cout, std::endl.
+#include <functional>		// std::function
+
+#include "c_core.h"			// Core simulator functionality
+#include "devices.h"		// JK flip-flop Device
+#include "game_of_life.h"	// Game of life Device
+
+// A pair of jk flip-flops built with AddComponentsInParallel(), along with a builder (between them) that fails, so that
+// the flip-flops built after it have to be moved down into it's place.
+class FlipFlopPair : public Device {
+	public:
+		FlipFlopPair(Device* parent_device_pointer, std::string name, bool monitor_on = false, std::vector<state_descriptor> in_pin_default_states = {})
+		 : Device(parent_device_pointer, name, "flip_flop_pair", {"clk", "not_c"}, {"q_0", "q_1"}, monitor_on, in_pin_default_states) {
+			Build();
+			Stabilise();
+		}
+		void Build(void) override {
+			std::vector<std::function<Component*()>> flip_flop_builders;
+			flip_flop_builders.push_back([this]() {
+				return new JK_FF_ASPC(this, "ff_0", false, {{"j", true}, {"k", true}, {"not_p", true}, {"not_c", true}});
+			});
+			flip_flop_builders.push_back([]() {
+				return static_cast<Component*>(0);
+			});
+			flip_flop_builders.push_back([this]() {
+				return new JK_FF_ASPC(this, "ff_1", false, {{"j", true}, {"k", true}, {"not_p", true}, {"not_c", true}});
+			});
+			m_all_built_flag = AddComponentsInParallel(flip_flop_builders);
+			for (const auto& this_flip_flop_name : {"ff_0", "ff_1"}) {
+				Connect("clk", this_flip_flop_name, "clk");
+				Connect("not_c", this_flip_flop_name, "not_c");
+				ChildMarkOutputNotConnected(this_flip_flop_name, "not_q");
+			}
+			ChildConnect("ff_0", {"q", "parent", "q_0"});
+			ChildConnect("ff_1", {"q", "parent", "q_1"});
+		}
+		bool m_all_built_flag = true;
+};
+
+bool ReportMatch(std::string const& build_description, std::vector<std::vector<std::vector<bool>>> const& probed_states,
+	std::vector<std::vector<std::vector<bool>>> const& expected_probed_states) {
+	// Compare the Probe samples from a Simulation built in parallel with those from one built sequentially.
+	bool match_flag = (probed_states == expected_probed_states);
+	std::cout << build_description << (match_flag ? ": match" : ": MISMATCH") << std::endl;
+	return match_flag;
+}
+
+void BuildGameOfLife(Simulation& sim, const int x_dimension, const bool set_blinker_flag, const bool monitor_on) {
+	// Add a game of life Device, with a Clock and a Probe on all of it's cells. If set_blinker_flag is true the cells
+	// are cleared and three in a row are set 'alive' (a 'blinker'), otherwise they keep their random starting states.
+	int cell_count = x_dimension * x_dimension;
+	std::vector<state_descriptor> in_pin_default_states = {{"not_clear_cycle", true}};
+	std::vector<std::string> output_identifiers = {};
+	for (int cell_id = 0; cell_id < cell_count; cell_id ++) {
+		std::string cell_identifier = "cell_" + std::to_string(cell_id);
+		in_pin_default_states.push_back({cell_identifier + "_not_clear_state", true});
+		in_pin_default_states.push_back({cell_identifier + "_not_preset_state", true});
+		output_identifiers.push_back(cell_identifier + "_state");
+	}
+	sim.AddComponent(new GameOfLife(&sim, "game_of_life", x_dimension, monitor_on, in_pin_default_states));
+
+	// Once we have added all our devices, call the simulation's Stabilise() method to finish setup.
+	sim.Stabilise();
+
+	// Add a Clock and a Probe.
+	sim.AddClock("clock_0", {false, true}, monitor_on);
+	sim.ClockConnect("clock_0", "game_of_life", "clk");
+	sim.AddProbe("cell_states", "test_sim:game_of_life", {output_identifiers}, "clock_0", {18, x_dimension, {" ", "■"}});
+
+	sim.ChildSet("game_of_life", "not_clear_cycle", false);
+	sim.ChildSet("game_of_life", "not_clear_cycle", true);
+	if (set_blinker_flag) {
+		for (int cell_id = 0; cell_id < cell_count; cell_id ++) {
+			sim.ChildSet("game_of_life", "cell_" + std::to_string(cell_id) + "_not_clear_state", false);
+			sim.ChildSet("game_of_life", "cell_" + std::to_string(cell_id) + "_not_clear_state", true);
+		}
+		int initial_offset = cell_count / 2;
+		for (const auto& this_cell_id : {initial_offset - x_dimension, initial_offset, initial_offset + x_dimension}) {
+			sim.ChildSet("game_of_life", "cell_" + std::to_string(this_cell_id) + "_not_preset_state", false);
+			sim.ChildSet("game_of_life", "cell_" + std::to_string(this_cell_id) + "_not_preset_state", true);
+		}
+	}
+}
+
+void BuildFlipFlopPair(Simulation& sim, const bool monitor_on) {
+	// Add a FlipFlopPair Device (one of it's builders fails), with a Clock and a Probe on it's outputs.
+	sim.AddComponent(new FlipFlopPair(&sim, "test_pair", monitor_on, {{"not_c", true}}));
+	sim.ChildMarkOutputNotConnected("test_pair", "q_0");
+	sim.ChildMarkOutputNotConnected("test_pair", "q_1");
+	sim.Stabilise();
+	sim.AddClock("clock_0", {false, true}, monitor_on);
+	sim.ClockConnect("clock_0", "test_pair", "clk");
+	sim.AddProbe("pair_outputs", "test_sim:test_pair", {"q_0", "q_1"}, "clock_0");
+	sim.ChildSet("test_pair", "not_c", false);
+	sim.ChildSet("test_pair", "not_c", true);
+}
+
+int main () {
+	// Verbosity flags. Set verbose & monitor_on equal to true to display verbose simulation output in the console.
+	bool verbose = false;
+	bool monitor_on = false;
+	bool print_probe_samples = true;
+
+	// Square grid base dimension, and number of ticks to simulate (three game iterations).
+	int x_dimension = 6;
+	int tick_count = 18 * 3;
+
+	// Every Simulation below is seeded the same, so that random starting states can be compared too.
+	solver_configuration sequential_solver_conf = {false, 0};
+	sequential_solver_conf.seed = 7;
+	solver_configuration parallel_solver_conf = sequential_solver_conf;
+	parallel_solver_conf.use_parallel_build = true;
+	bool all_match_flag = true;
+
+	// A game of life 'blinker', built with the cells one after another and then with them built in parallel.
+	Simulation sim("test_sim", verbose, sequential_solver_conf);
+	BuildGameOfLife(sim, x_dimension, true, monitor_on);
+	sim.Run(tick_count, true, verbose, print_probe_samples);
+	Simulation parallel_sim("test_sim", verbose, parallel_solver_conf);
+	BuildGameOfLife(parallel_sim, x_dimension, true, monitor_on);
+	parallel_sim.Run(tick_count, true, verbose, false, true);
+	all_match_flag &= ReportMatch("Game of life built in parallel", parallel_sim.GetProbedStates({"all"}), sim.GetProbedStates({"all"}));
+
+	// Cells built in parallel draw their random starting states from a stream of their own, so two parallel builds
+	// start (and so carry on) the same, whichever threads the cells were built on.
+	Simulation first_random_sim("test_sim", verbose, parallel_solver_conf);
+	BuildGameOfLife(first_random_sim, x_dimension, false, monitor_on);
+	first_random_sim.Run(tick_count, true, verbose, false, true);
+	Simulation second_random_sim("test_sim", verbose, parallel_solver_conf);
+	BuildGameOfLife(second_random_sim, x_dimension, false, monitor_on);
+	second_random_sim.Run(tick_count, true, verbose, false, true);
+	all_match_flag &= ReportMatch("Game of life with random starting states built in parallel twice", second_random_sim.GetProbedStates({"all"}),
+		first_random_sim.GetProbedStates({"all"}));
+
+	// A builder that fails is reported (as an error) and left out, either way.
+	Simulation pair_sim("test_sim", verbose, sequential_solver_conf);
+	BuildFlipFlopPair(pair_sim, monitor_on);
+	pair_sim.Run(tick_count, true, verbose, false, true);
+	Simulation parallel_pair_sim("test_sim", verbose, parallel_solver_conf);
+	BuildFlipFlopPair(parallel_pair_sim, monitor_on);
+	parallel_pair_sim.Run(tick_count, true, verbose, false, true);
+	all_match_flag &= ReportMatch("Flip-flop pair with a failed builder built in parallel", parallel_pair_sim.GetProbedStates({"all"}),
+		pair_sim.GetProbedStates({"all"}));
+	bool failures_reported_flag = (!static_cast<FlipFlopPair*>(pair_sim.GetChildComponentPointer("test_pair"))->m_all_built_flag
+		&& !static_cast<FlipFlopPair*>(parallel_pair_sim.GetChildComponentPointer("test_pair"))->m_all_built_flag);
+	std::cout << "Failed builder reported" << (failures_reported_flag ? ": yes" : ": NO") << std::endl;
+
+	return (all_match_flag && failures_reported_flag) ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <iostream>			// std::cout, std::endl.
+#include <limits>			// std::numeric_limits
+
+#include "c_core.h"			// Core simulator functionality
+#include "devices.h"		// Counter Device
+
+void SetPropagateEpochs(Device* device_pointer, const unsigned int new_propagate_epoch) {
+	// Set the propagation epoch count of a Device and of every Device below it.
+	device_pointer->SetPropagateEpoch(new_propagate_epoch);
+	for (int local_component_index = 0; local_component_index < device_pointer->GetLocalComponentCount(); local_component_index ++) {
+		Component* child_component_pointer = device_pointer->GetChildComponentPointer(local_component_index);
+		if (child_component_pointer->GetDeviceFlag()) {
+			SetPropagateEpochs(static_cast<Device*>(child_component_pointer), new_propagate_epoch);
+		}
+	}
+}
+
+int main () {
+	// Verbosity flags. Set verbose & monitor_on equal to true to display verbose simulation output in the console.
+	bool verbose = false;
+	bool monitor_on = false;
+	bool print_probe_samples = true;
+
+	// Counter width, and number of ticks to simulate.
+	int counter_width = 4;
+	int tick_count = 64;
+
+	// Instantiate the top-level Device (the Simulation).
+	Simulation sim("test_sim", verbose);
+
+	// Add a counter Device, counting up while run is high.
+	sim.AddComponent(new N_Bit_Counter(&sim, "test_counter", counter_width, monitor_on, {{"run", true}}));
+	std::vector<std::string> output_pin_names = {};
+	for (int bit_index = 0; bit_index < counter_width; bit_index ++) {
+		std::string output_pin_name = "q_" + std::to_string(bit_index);
+		sim.ChildMarkOutputNotConnected("test_counter", output_pin_name);
+		output_pin_names.push_back(output_pin_name);
+	}
+
+	// Once we have added all our devices, call the simulation's Stabilise() method to finish setup.
+	sim.Stabilise();
+
+	// Add a Clock and connect it to the clk input on the counter.
+	sim.AddClock("clock_0", {false, true}, monitor_on);
+	sim.ClockConnect("clock_0", "test_counter", "clk");
+
+	// Add a Probe to the counter's outputs.
+	sim.AddProbe("counter outputs", "test_sim:test_counter", {output_pin_names}, "clock_0");
+
+	// Make an identical copy of the Simulation, then move the propagation epoch count of every Device in it to just
+	// short of the point where it has to be renumbered, which will happen part way through the run.
+	Simulation* wrapped_sim_pointer = sim.Clone();
+	unsigned int near_limit_epoch = std::numeric_limits<unsigned int>::max() - 16;
+	SetPropagateEpochs(wrapped_sim_pointer, near_limit_epoch);
+
+	// Run both, the copy's Probe samples should be exactly the same as the original's.
+	sim.Run(tick_count, true, verbose, print_probe_samples);
+	wrapped_sim_pointer->Run(tick_count, true, verbose, false, true);
+	bool match_flag = (wrapped_sim_pointer->GetProbedStates({"all"}) == sim.GetProbedStates({"all"}));
+	std::cout << "Propagation epoch renumbered mid-run" << (match_flag ? ": match" : ": MISMATCH") << std::endl;
+	delete wrapped_sim_pointer;
+
+	return match_flag ? 0 : 1;
+}
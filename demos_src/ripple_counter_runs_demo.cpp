@@ -0,0 +1,125 @@
+#include <iostream>			// std::cout, std::endl.
+
+#include "c_core.h"			// Core simulator functionality
+#include "devices.h"		// JK flip-flop Device
+
+bool ReportMatch(std::string const& run_description, std::vector<std::vector<std::vector<bool>>> const& probed_states,
+	std::vector<std::vector<std::vector<bool>>> const& expected_probed_states) {
+	// Compare the Probe samples from one way of running the Simulation with those from a plain sequential Run().
+	bool match_flag = (probed_states == expected_probed_states);
+	std::cout << run_description << (match_flag ? ": match" : ": MISMATCH") << std::endl;
+	return match_flag;
+}
+
+void BuildRippleCounter(Simulation& sim, const int stage_count, const bool monitor_on) {
+	// Add a ripple counter built from jk flip-flops with asynchronous preset and clear. Each flip-flop is it's own
+	// top-level Device, and each one after the first is clocked by the not_q output of the one before.
+	std::vector<std::string> stage_names = {};
+	for (int stage_index = 0; stage_index < stage_count; stage_index ++) {
+		std::string stage_name = "ff_" + std::to_string(stage_index);
+		sim.AddComponent(new JK_FF_ASPC(&sim, stage_name, monitor_on, {{"j", true}, {"k", true}, {"not_p", true}, {"not_c", true}}));
+		if (stage_index > 0) {
+			sim.ChildConnect(stage_names.back(), {"not_q", stage_name, "clk"});
+		}
+		sim.ChildMarkOutputNotConnected(stage_name, "q");
+		stage_names.push_back(stage_name);
+	}
+	sim.ChildMarkOutputNotConnected(stage_names.back(), "not_q");
+
+	// Once we have added all our devices, call the simulation's Stabilise() method to finish setup.
+	sim.Stabilise();
+
+	// Pulse each flip-flop's not_c input low so that the counter starts from 0.
+	for (const auto& this_stage_name : stage_names) {
+		sim.ChildSet(this_stage_name, "not_c", false);
+		sim.ChildSet(this_stage_name, "not_c", true);
+	}
+
+	// Add a Clock and connect it to the clk input on the first flip-flop.
+	sim.AddClock("clock_0", {false, true}, monitor_on);
+	sim.ClockConnect("clock_0", stage_names.front(), "clk");
+
+	// Add a Probe to the q output of every flip-flop.
+	for (const auto& this_stage_name : stage_names) {
+		sim.AddProbe(this_stage_name + " output", "test_sim:" + this_stage_name, {"q"}, "clock_0");
+	}
+}
+
+int main () {
+	// Verbosity flags. Set verbose & monitor_on equal to true to display verbose simulation output in the console.
+	bool verbose = false;
+	bool monitor_on = false;
+	bool print_probe_samples = true;
+
+	// Number of flip-flops in the counter, and number of ticks to simulate (enough for every flip-flop to change).
+	int stage_count = 5;
+	int tick_count = 72;
+
+	// Instantiate the top-level Device (the Simulation).
+	Simulation sim("test_sim", verbose);
+
+	// Add the ripple counter, with a Clock and Probes.
+	BuildRippleCounter(sim, stage_count, monitor_on);
+
+	// Each of the ways of running the Simulation below starts from this same, un-run, state.
+	// A Clone() is a separate copy of the Simulation, run here after the original has been.
+	Simulation* cloned_sim_pointer = sim.Clone();
+
+	// Branch() forks the Simulation into separate processes, here running each branch in the same way.
+	int branch_count = 2;
+	std::vector<branch_result> branch_results = sim.Branch(branch_count, [tick_count](Simulation* branch_sim_pointer, const int branch_index) {
+		branch_sim_pointer->Run(tick_count, true, false, false, true);
+	}, {"all"});
+
+	// RunPartitioned() splits the top-level Devices between several processes, which swap boundary pin changes
+	// every tick. It returns the samples from all of the Probes.
+	// Given an optimistic window, each process instead runs up to that many ticks ahead of the others and rolls back
+	// whenever a boundary pin change arrives late.
+	std::vector<int> partition_counts = {2, 3, 2, 3};
+	std::vector<int> optimistic_windows = {0, 0, 4, 8};
+	std::vector<std::vector<std::vector<std::vector<bool>>>> partitioned_probed_states = {};
+	for (size_t i = 0; i < partition_counts.size(); i ++) {
+		partitioned_probed_states.push_back(sim.RunPartitioned(tick_count, partition_counts[i], optimistic_windows[i]));
+	}
+
+	// Run the Simulation sequentially - this is the result that the others are checked against.
+	sim.Run(tick_count, true, verbose, print_probe_samples);
+	std::vector<std::vector<std::vector<bool>>> expected_probed_states = sim.GetProbedStates({"all"});
+	bool all_match_flag = true;
+
+	cloned_sim_pointer->Run(tick_count, true, verbose, false, true);
+	all_match_flag &= ReportMatch("Clone() then Run()", cloned_sim_pointer->GetProbedStates({"all"}), expected_probed_states);
+	delete cloned_sim_pointer;
+
+	for (int branch_index = 0; branch_index < branch_count; branch_index ++) {
+		std::string run_description = "Branch() " + std::to_string(branch_index) + " then Run()";
+		all_match_flag &= branch_results[branch_index].completed_flag;
+		all_match_flag &= ReportMatch(run_description, branch_results[branch_index].probed_states, expected_probed_states);
+	}
+	for (size_t i = 0; i < partition_counts.size(); i ++) {
+		std::string run_description = "RunPartitioned() over " + std::to_string(partition_counts[i]) + " processes";
+		if (optimistic_windows[i] > 0) {
+			run_description += ", optimistic window " + std::to_string(optimistic_windows[i]);
+		}
+		all_match_flag &= ReportMatch(run_description, partitioned_probed_states[i], expected_probed_states);
+	}
+
+	// Each threaded solver mode runs it's own copy of the counter. With no minimum work or gain, every pending flip-flop is
+	// handed to a worker, so these tiny Devices exercise the same paths as a large design would.
+	std::vector<std::string> solver_mode_descriptions = {"Threaded solver", "Threaded solver, persistent workers", "Cost model", "Cost model, persistent workers"};
+	std::vector<bool> persistent_worker_flags = {false, true, false, true};
+	std::vector<bool> cost_model_flags = {false, false, true, true};
+	for (size_t i = 0; i < solver_mode_descriptions.size(); i ++) {
+		solver_configuration solver_conf = {true, 0};
+		solver_conf.use_persistent_workers = persistent_worker_flags[i];
+		solver_conf.use_cost_model = cost_model_flags[i];
+		solver_conf.min_offload_work = 0.0;
+		solver_conf.min_parallel_gain = 0.0;
+		Simulation solver_mode_sim("test_sim", false, solver_conf);
+		BuildRippleCounter(solver_mode_sim, stage_count, false);
+		solver_mode_sim.Run(tick_count, true, false, false, true);
+		all_match_flag &= ReportMatch(solver_mode_descriptions[i] + " Run()", solver_mode_sim.GetProbedStates({"all"}), expected_probed_states);
+	}
+
+	return all_match_flag ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#include "c_core.h"			// Core simulator functionality
+#include "devices.h"		// JK flip-flop Device
+
+int main () {
+	// Verbosity flags. Set verbose & monitor_on equal to true to display verbose simulation output in the console.
+	bool verbose = false;
+	bool monitor_on = false;
+	bool print_probe_samples = true;
+	
+	// Instantiate the top-level Device (the Simulation) with unknown states on, so that Gate inputs and undefaulted
+	// Device pins start as X rather than at random.
+	solver_configuration solver_conf = {false, 0};
+	solver_conf.use_unknown_states = true;
+	Simulation sim("test_sim", verbose, solver_conf);
+	
+	// Add a jk flip-flop Device with asynchronous preset and clear. With both j and k low it only holds it's state, so
+	// it's outputs stay X after stabilising.
+	sim.AddComponent(new JK_FF_ASPC(&sim, "test_ff", monitor_on, {{"j", false}, {"k", false}, {"not_p", true}, {"not_c", true}}));
+	
+	// Once we have added all our devices, call the simulation's Stabilise() method to finish setup.
+	// The build report counts the out pins left X and names those of the top-level Devices.
+	sim.Stabilise();
+	
+	// Add a Clock and connect it to the clk input on the jk flip-flop.
+	sim.AddClock("clock_0", {false, true}, monitor_on);
+	sim.ClockConnect("clock_0", "test_ff", "clk");
+	
+	// Add a Probe to the jk flip-flop's outputs. Samples that are X are printed as X.
+	sim.AddProbe("flip-flop outputs", "test_sim:test_ff", {"q", "not_q"}, "clock_0");
+	
+	// Clocking the flip-flop does not clear the X.
+	sim.Run(4, true, verbose, false);
+	
+	// Pulsing not_c low clears the flip-flop, q is now known to be low.
+	sim.ChildSet("test_ff", "not_c", false);
+	sim.ChildSet("test_ff", "not_c", true);
+	sim.Run(2, false, verbose, false);
+	
+	// With j and k high the flip-flop toggles on every rising clock edge.
+	sim.ChildSet("test_ff", "j", true);
+	sim.ChildSet("test_ff", "k", true);
+	sim.Run(6, false, verbose, print_probe_samples);
+	
+	return 0;
+}
@@ -22,6 +22,7 @@
 #include <string>					// std::string.
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::vector
+#include <unordered_map>			// std::unordered_map
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
@@ -40,7 +41,7 @@ Clock::Clock(Simulation* top_level_sim_pointer, std::string const& clock_name, s
 
 Clock::~Clock() {
 	PurgeClock();
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		std::cout << "Clock dtor for " << m_name << " @ " << this << std::endl << std::endl;
 	}
 }
@@ -58,7 +59,7 @@ void Clock::AddToProbeList(std::string const& probe_identifier, Probe* probe_poi
 
 void Clock::Tick(void) {
 	// Print output pin changes.
-	bool verbose_flag = m_top_level_sim_pointer->mg_verbose_flag;
+	bool verbose_flag = m_top_level_sim_pointer->m_verbose_flag;
 	if (m_monitor_on || (verbose_flag)) {
 		std::string message = "\nT: " + std::to_string(m_index) + " " + KBLD + KYEL + "CLOCKSET: " + RST + "On tick " + KBLD + std::to_string(m_index) + RST + " " + m_name + ":clock output set to " + BoolToChar(m_toggle_pattern[m_sub_index]);
 		m_top_level_sim_pointer->LogMessage(message);
@@ -99,6 +100,7 @@ void Clock::Connect(std::string const& target_component_name, std::string const&
 					new_connection_descriptor.target_component_pointer = target_component_pointer;
 					new_connection_descriptor.target_pin_port_index = target_pin_port_index;
 					m_connections.push_back(new_connection_descriptor);
+					Component::BuildFanout(m_connections, m_fanout);
 					target_component_pointer->SetPinDrivenFlag(target_pin_port_index, false, true);
 				} else {
 					// Log build error here.		-- Target pin is not an in pin.
@@ -126,14 +128,25 @@ void Clock::Propagate(const bool verbose_flag) {
 	if (verbose_flag) {
 		m_top_level_sim_pointer->LogMessage("~S0");
 	}
-	for (const auto& this_connection_descriptor : m_connections) {
-		this_connection_descriptor.target_component_pointer->Set(this_connection_descriptor.target_pin_port_index, m_out_pin_state);
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		PropagateToTargets<verbose_logging>();
+	} else {
+		PropagateToTargets<quiet_logging>();
 	}
 	if (verbose_flag) {
 		m_top_level_sim_pointer->LogMessage("~E0");
 	}
 }
 
+template <class logging_policy>
+void Clock::PropagateToTargets() {
+	for (const auto& this_target : m_fanout.gate_targets) {
+		this_target.target_gate_pointer->SetLogic<logging_policy>(this_target.target_pin_port_index, m_out_pin_state, false);
+	}
+	// Clock nets are broadcast to their target Devices in bulk, see Device::BroadcastSet().
+	Device::BroadcastSet<logging_policy>(m_fanout.device_targets, m_out_pin_state);
+}
+
 bool Clock::GetTickedFlag() {
 	return m_ticked_flag;
 }
@@ -149,6 +162,22 @@ void Clock::TriggerProbes() {
 	m_ticked_flag = false;
 }
 
+void Clock::RewindTo(const int tick_index) {
+	// Put the Clock back to the start of tick tick_index of a Run() from tick 0, dropping any later Probe samples. The
+	// states of it's targets are not touched, see Simulation::RestorePartitionState().
+	size_t pattern_length = m_toggle_pattern.size();
+	m_index = tick_index;
+	m_sub_index = tick_index % pattern_length;
+	m_out_pin_state = (tick_index == 0) ? m_toggle_pattern[0] : m_toggle_pattern[(tick_index - 1) % pattern_length];
+	m_ticked_flag = false;
+	if (m_state_history.size() > size_t(tick_index)) {
+		m_state_history.resize(tick_index);
+	}
+	for (const auto& this_probe_descriptor : m_probes) {
+		this_probe_descriptor.probe_pointer->DiscardSamplesFrom(tick_index);
+	}
+}
+
 void Clock::PurgeTargetComponentConnections(Component* target_component_pointer) {
 	std::vector<connection_descriptor> new_connections = {};
 	for (const auto& this_connection_descriptor : m_connections) {
@@ -158,17 +187,36 @@ void Clock::PurgeTargetComponentConnections(Component* target_component_pointer)
 			new_connection_descriptor.target_pin_port_index = this_connection_descriptor.target_pin_port_index;
 			new_connections.push_back(new_connection_descriptor);
 		} else {
-			if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+			if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 				std::cout << "Purging " << target_component_pointer->GetFullName() << " from Clock " << m_name << " m_connections." << std::endl;
 			}
 		}
 	}
 	m_connections = new_connections;
+	Component::BuildFanout(m_connections, m_fanout);
+}
+
+void Clock::RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map) {
+	for (auto& this_connection_descriptor : m_connections) {
+		auto this_mapping = pointer_map.find(this_connection_descriptor.target_component_pointer);
+		if (this_mapping != pointer_map.end()) {
+			this_connection_descriptor.target_component_pointer = this_mapping->second;
+		}
+	}
+	Component::BuildFanout(m_connections, m_fanout);
+}
+
+Clock* Clock::CloneInto(Simulation* top_level_sim_pointer) {
+	// Connections are remapped by the cloned Simulation, and cloned Probes add themselves to the copy's probe list.
+	Clock* cloned_clock_pointer = new Clock(*this);
+	cloned_clock_pointer->m_top_level_sim_pointer = top_level_sim_pointer;
+	cloned_clock_pointer->m_probes.clear();
+	return cloned_clock_pointer;
 }
 
 void Clock::PurgeClock(void) {
 	std::string header;
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "Purging -> CLOCK : " + m_name + " @ " + PointerToString(static_cast<void*>(this));
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -180,7 +228,7 @@ void Clock::PurgeClock(void) {
 			Component* target_component_pointer = this_connection_descriptor.target_component_pointer;
 			int target_pin_port_index = this_connection_descriptor.target_pin_port_index;
 			target_component_pointer->SetPinDrivenFlag(target_pin_port_index, 0, false);
-			if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+			if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 				std::cout << "Component " << target_component_pointer->GetFullName() << " in pin " << target_component_pointer->GetPinName(target_pin_port_index) << " drive in set to false." << std::endl;
 			}
 		}
@@ -205,7 +253,7 @@ void Clock::PurgeClock(void) {
 		// Finally we purge the Clock from the parent Simulation's m_clocks vector.
 		m_top_level_sim_pointer->PurgeClockDescriptorFromSimulation(this);
 	}
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "CLOCK : " + m_name + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged.";
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -222,7 +270,7 @@ void Clock::PurgeProbeDescriptorFromClock(Probe* target_probe_pointer) {
 			new_probe_descriptor.probe_pointer = this_probe_descriptor.probe_pointer;
 			new_probes.push_back(new_probe_descriptor);
 		} else {
-			if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+			if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 				std::cout << "Purging " << this_probe_descriptor.probe_name << " from Clock " << m_name << " m_probes." << std::endl;
 			}
 		}
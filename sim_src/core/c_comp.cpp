@@ -23,34 +23,60 @@
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::vector
 #include <algorithm>				// std::sort
+#include <unordered_set>			// std::unordered_set
+#include <mutex>					// std::mutex, std::unique_lock
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
 #include "strnatcmp.h"
 
-bool Component::mg_verbose_flag;
-bool Component::mg_verbose_destructor_flag;
-
 Component::~Component() {
-	if (mg_verbose_destructor_flag) {
+	// By the time the top-level Simulation's own Component dtor runs, the rest of the Simulation is gone.
+	if ((static_cast<Component*>(m_top_level_sim_pointer) != this) && m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		std::cout << "Component dtor for " << m_full_name << " @ " << this << std::endl << std::endl;
 	}
 }
 
+std::string const* Component::GetSharedName(std::string const& name) {
+	// Component, type and pin names are repeated across every instance of a given Device (each GameOfLife_Cell has
+	// it's own "not_0", "and_0", "input_0", "output", etc). Rather than every instance holding it's own copy, all
+	// instances refer to the single copy held here. Elements of a std::unordered_set never move once inserted, so
+	// the returned pointer remains valid for the lifetime of the program.
+	static std::mutex shared_names_lock;
+	static std::unordered_set<std::string> shared_names;
+	std::unique_lock<std::mutex> lock(shared_names_lock);
+	return &(*shared_names.insert(name).first);
+}
+
+void Component::BuildFanout(std::vector<connection_descriptor> const& connections, fanout_descriptor& fanout) {
+	// Split the connections by target type, preserving their order within each type. Gates only ever queue themselves
+	// to propagate and Devices only ever queue themselves to Solve() (or buffer an out pin change), so Setting all the
+	// Gate targets before all the Device targets does not change the outcome of a Propagate() call.
+	fanout.gate_targets.clear();
+	fanout.device_targets.clear();
+	for (const auto& this_connection_descriptor : connections) {
+		if (this_connection_descriptor.target_component_pointer->GetDeviceFlag()) {
+			fanout.device_targets.push_back({static_cast<Device*>(this_connection_descriptor.target_component_pointer), this_connection_descriptor.target_pin_port_index});
+		} else {
+			fanout.gate_targets.push_back({static_cast<Gate*>(this_connection_descriptor.target_component_pointer), this_connection_descriptor.target_pin_port_index});
+		}
+	}
+}
+
 std::string Component::GetName() {
-	return m_name;
+	return *m_name;
 }
 
 std::string Component::GetFullName() {
 	return m_full_name;
 }
 
-bool Component::GetDeviceFlag() {
-	return m_device_flag;
+bool Component::GetRelocatedFlag() {
+	return m_relocated_flag;
 }
 
 std::string Component::GetComponentType() {
-	return m_component_type;
+	return *m_component_type;
 }
 
 int Component::GetLocalComponentIndex() {
@@ -73,15 +99,28 @@ bool Component::GetPinState(const int pin_port_index) {
 	return m_pins[pin_port_index].state;
 }
 
+bool Component::GetPinUnknown(const int pin_port_index) {
+	return m_pins[pin_port_index].unknown;
+}
+
+uint64_t Component::GetPinStateHash() {
+	// Hash of the logic value on every pin, used to fingerprint Device state (see Device::CheckForOscillation()).
+	uint64_t pin_state_hash = 0;
+	for (const auto& this_pin : m_pins) {
+		pin_state_hash = MixHash(pin_state_hash ^ (uint64_t(this_pin.state) | (uint64_t(this_pin.unknown) << 1)));
+	}
+	return pin_state_hash;
+}
+
 std::string Component::GetPinName(int pin_port_index) {
-	return m_pins[pin_port_index].name;
+	return *m_pins[pin_port_index].name;
 }
 
 std::vector<std::string> Component::GetSortedInPinNames() {
 	std::vector<std::string> sorted_in_pin_names = {};
 	for (const auto& this_pin : m_pins) {
 		if ((this_pin.direction == 1) || (this_pin.direction == 3)) {
-			sorted_in_pin_names.push_back(this_pin.name);
+			sorted_in_pin_names.push_back(*this_pin.name);
 		}
 	}
 	std::sort(sorted_in_pin_names.begin(), sorted_in_pin_names.end(), compareNat);
@@ -92,7 +131,7 @@ std::vector<std::string> Component::GetSortedOutPinNames() {
 	std::vector<std::string> sorted_out_pin_names = {};
 	for (const auto& this_pin : m_pins) {
 		if ((this_pin.direction == 2) || (this_pin.direction == 4)) {
-			sorted_out_pin_names.push_back(this_pin.name);
+			sorted_out_pin_names.push_back(*this_pin.name);
 		}
 	}
 	std::sort(sorted_out_pin_names.begin(), sorted_out_pin_names.end(), compareNat);
@@ -106,7 +145,7 @@ int Component::GetPinDirection(int pin_port_index) {
 int Component::GetPinDirection(std::string const& pin_name) {
 	int pin_direction = 0;
 	for (const auto& this_pin: m_pins) {
-		if (this_pin.name == pin_name) {
+		if (*this_pin.name == pin_name) {
 			pin_direction = this_pin.direction;
 			break;
 		}
@@ -117,7 +156,7 @@ int Component::GetPinDirection(std::string const& pin_name) {
 int Component::GetPinPortIndex(std::string const& pin_name) {
 	int pin_port_index = 0;
 	for (const auto& this_pin : m_pins) {
-		if (this_pin.name == pin_name) {
+		if (*this_pin.name == pin_name) {
 			pin_port_index = this_pin.port_index;
 			break;
 		}
@@ -128,7 +167,7 @@ int Component::GetPinPortIndex(std::string const& pin_name) {
 bool Component::CheckIfPinExists(std::string const& target_pin_name) {
 	bool pin_exists = false;
 	for (const auto& this_pin : m_pins) {
-		if (this_pin.name == target_pin_name) {
+		if (*this_pin.name == target_pin_name) {
 			pin_exists = true;
 			break;
 		}
@@ -137,7 +176,7 @@ bool Component::CheckIfPinExists(std::string const& target_pin_name) {
 }
 
 std::vector<bool> Component::CheckIfPinDriven(int pin_port_index) {
-	return m_pins[pin_port_index].drive;
+	return {m_pins[pin_port_index].drive[0], m_pins[pin_port_index].drive[1]};
 }
 
 void Component::SetPinDrivenFlag(int pin_port_index, bool drive_mode, bool state_to_set) {
@@ -148,12 +187,29 @@ void Component::SetPinDrivenFlag(int pin_port_index, bool drive_mode, bool state
 	}
 }
 
+void Component::SavePinStates(std::vector<unsigned char>& state_buffer) {
+	// One byte per pin, state in bit 0 and unknown in bit 1.
+	for (const auto& this_pin : m_pins) {
+		state_buffer.push_back(static_cast<unsigned char>(this_pin.state) | (static_cast<unsigned char>(this_pin.unknown) << 1));
+	}
+}
+
+unsigned char const* Component::RestorePinStates(unsigned char const* state_pointer) {
+	for (auto& this_pin : m_pins) {
+		this_pin.state = ((*state_pointer & 1) != 0);
+		this_pin.unknown = ((*state_pointer & 2) != 0);
+		this_pin.state_changed = false;
+		state_pointer ++;
+	}
+	return state_pointer;
+}
+
 void Component::PrintInPinStates() {
-	std::cout << m_name << ": [ ";
+	std::cout << *m_name << ": [ ";
 	for (const auto& in_pin_name: GetSortedInPinNames()) {
 		int in_pin_port_index = GetPinPortIndex(in_pin_name);
 		if (m_pins[in_pin_port_index].direction == 1) {
-			std::cout << m_pins[in_pin_port_index].name;
+			std::cout << *m_pins[in_pin_port_index].name;
 			if (m_pins[in_pin_port_index].state) {
 				std::cout << ": T ";
 			} else {
@@ -165,11 +221,11 @@ void Component::PrintInPinStates() {
 }
 
 void Component::PrintOutPinStates() {
-	std::cout << m_name << ": [ ";
+	std::cout << *m_name << ": [ ";
 	for (const auto& out_pin_name: GetSortedOutPinNames()) {
 		int out_pin_port_index = GetPinPortIndex(out_pin_name);
 		if (m_pins[out_pin_port_index].direction == 2) {
-			std::cout << m_pins[out_pin_port_index].name;
+			std::cout << *m_pins[out_pin_port_index].name;
 			if (m_pins[out_pin_port_index].state) {
 				std::cout << ": T ";
 			} else {
@@ -28,6 +28,8 @@
 #include <string>					// std::string.
 #include <vector>					// std::vector
 #include <unordered_map>			// std::unordered_map
+#include <atomic>					// std::atomic
+#include <functional>				// std::function
 #include <termios.h>				// terminal settings data structure
 
 // NOTE - c_structs.h must be included first after the library headers as it contains essential forward definitions.
@@ -45,6 +47,7 @@ class Component {
 		virtual void Initialise(void) = 0;
 		virtual void Connect(std::vector<std::string> connection_parameters) = 0;
 		virtual void Set(const int pin_port_index, const bool state_to_set) = 0;
+		virtual void SetUnknown(const int pin_port_index, const bool high_impedance) = 0;
 		virtual void Propagate(void) = 0;
 		virtual void PrintPinStates(int max_levels) = 0;
 		virtual void ReportUnConnectedPins(void) = 0;
@@ -55,13 +58,19 @@ class Component {
 		
 		bool GetMonitorOnFlag(void);
 		std::string GetName(void);
-		bool GetDeviceFlag(void);
+		// Defined here so that it can be inlined into the solver loops.
+		bool GetDeviceFlag(void) {
+			return m_device_flag;
+		}
+		bool GetRelocatedFlag(void);
 		std::string GetFullName(void);
 		std::string GetComponentType(void);
 		int GetLocalComponentIndex(void);
 		void SetLocalComponentIndex(int new_local_component_index);
 		Simulation* GetTopLevelSimPointer(void);
 		bool GetPinState(const int pin_port_index);
+		bool GetPinUnknown(const int pin_port_index);
+		uint64_t GetPinStateHash(void);
 		std::string GetPinName(int pin_port_index);
 		std::vector<std::string> GetSortedInPinNames(void);
 		std::vector<std::string> GetSortedOutPinNames(void);
@@ -73,31 +82,29 @@ class Component {
 		void SetPinDrivenFlag(int pin_port_index, bool drive_mode, bool state_to_set);
 		void PrintInPinStates(void);
 		void PrintOutPinStates(void);
+		void SavePinStates(std::vector<unsigned char>& state_buffer);
+		unsigned char const* RestorePinStates(unsigned char const* state_pointer);
 		
-		static bool mg_verbose_flag;
-		static bool mg_verbose_destructor_flag;
+		static std::string const* GetSharedName(std::string const& name);
+		static void BuildFanout(std::vector<connection_descriptor> const& connections, fanout_descriptor& fanout);
 
 	protected:
 		bool m_monitor_on;
 		int m_nesting_level;
 		bool m_device_flag;
-		std::string m_name;
+		bool m_relocated_flag = false;		// Component lives in it's parent Device's Gate block, see Device::RelocateChildGates().
+		std::string const* m_name;
 		std::string m_full_name;
 		int m_CUID;
 		int m_local_component_index = 0;
-		std::string m_component_type;
+		std::string const* m_component_type;
 		Simulation* m_top_level_sim_pointer;
 		Device* m_parent_device_pointer;
 		std::vector<pin> m_pins;
 };
 
-// This typedef defines the type 'pointer to a Gate class member function that takes a vector of pin
-// structs as arguments and returns an output bool. This allows us to *dramatically* simplify the code
-// for declaring such function pointers and member functions that take them as arguments and/or return them.
-typedef bool (Gate::*operator_pointer)(std::vector<pin> const&);
-
 // Logic Gate Component sub-class.
-class Gate : public Component {
+class Gate final : public Component {
 	public:
 		Gate(Device* parent_device_pointer, std::string const& gate_name, std::string const& gate_type,
 			std::vector<std::string> in_pin_names = {}, bool monitor_on = false
@@ -108,6 +115,7 @@ class Gate : public Component {
 		void Initialise(void) override;
 		void Connect(std::vector<std::string> connection_parameters) override;
 		void Set(const int pin_port_index, const bool state_to_set) override;
+		void SetUnknown(const int pin_port_index, const bool high_impedance) override;
 		void Propagate(void) override;
 		void PrintPinStates(int max_levels) override;
 		void ReportUnConnectedPins(void) override;
@@ -116,18 +124,34 @@ class Gate : public Component {
 		void PurgeInboundConnections(Component* target_component_pointer) override;
 		void PurgeOutboundConnections(void) override;
 		
+		Gate* RelocateTo(void* destination);
+		Gate* CloneInto(Device* parent_device_pointer, void* destination);
+		void RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map);
+		fanout_descriptor const& GetFanout(void);
+		void AddToGateBatch(std::vector<gate_batch>& gate_batches, const int deferred_index);
+		unsigned char const* RestoreState(unsigned char const* state_pointer);
+		template <class logging_policy> void SetLogic(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+		template <class logging_policy> void PropagateOutput(void);
+		template <class logging_policy> void Evaluate(void);
+		template <class logging_policy> void ApplyEvaluation(const unsigned char new_logic);
+		
+		static unsigned char EvaluateOperator(const int operator_index, const uint64_t known_low, const uint64_t known_high, const uint64_t unknown);
+		static void EvaluateGateBatch(const int operator_index, gate_batch& batch);
+		
 	private:
-		void Evaluate(void);
-		operator_pointer GetOperatorPointer(std::string const& operator_name);
-		bool OperatorAnd(std::vector<pin> const& pins);
-		bool OperatorNand(std::vector<pin> const& pins);
-		bool OperatorOr(std::vector<pin> const& pins);
-		bool OperatorNor(std::vector<pin> const& pins);
-		bool OperatorNot(std::vector<pin> const& pins);
+		unsigned char ComputeOutput(void);
+		int GetOperatorIndex(std::string const& operator_name);
 		
 		int m_out_pin_port_index;
-		operator_pointer m_operator_function_pointer;
+		int m_operator_index;
+		bool m_packed_flag;					// In pin states are mirrored in m_in_pin_word (Gates with up to 64 in pins).
+		uint64_t m_in_pin_word = 0;
+		uint64_t m_in_pin_unknown_word = 0;
+		uint64_t m_in_pin_mask = 0;
+		bool m_deferred_flag = false;
 		std::vector<connection_descriptor> m_connections;
+		fanout_descriptor m_fanout;
+		bool m_moved_from_flag = false;
 };
 
 // Compound-logic Device Component sub-class. 
@@ -142,7 +166,8 @@ class Device : public Component {
 		// Override Component virtual methods.
 		void Initialise(void) override;
 		void Connect(std::vector<std::string> connection_parameters) override;
-		void Set(const int pin_port_index, const bool state_to_set) override;
+		void Set(const int pin_port_index, const bool state_to_set) override final;
+		void SetUnknown(const int pin_port_index, const bool high_impedance) override final;
 		void Propagate(void) override;
 		void PrintPinStates(int max_levels) override;
 		void ReportUnConnectedPins(void) override;
@@ -160,6 +185,7 @@ class Device : public Component {
 		void CreateBus(int pin_count, std::string const& pin_name_prefix, int pin_direction, std::vector<state_descriptor> in_pin_default_states = {});
 		void SetPin(pin& target_pin, std::vector<state_descriptor> pin_default_states);
 		void AddComponent(Component* new_component_pointer);
+		bool AddComponentsInParallel(std::vector<std::function<Component*()>> const& component_builders);
 		void AddGate(std::string const& component_name, std::string const& component_type, std::vector<std::string> const& in_pin_names, bool monitor_on = false);
 		void AddGate(std::string const& component_name, std::string const& component_type, bool monitor_on = false);
 		void AddMagicEventTrap(std::string const& target_pin_name, std::vector<bool> const& state_change,
@@ -173,57 +199,147 @@ class Device : public Component {
 		void Connect(std::string const& origin_pin_name, std::string const& target_component_name, std::string const& target_pin_name = "input");
 		void Stabilise(void);
 		Component* GetChildComponentPointer(std::string const& target_child_component_name);
+		Component* GetChildComponentPointer(const int local_component_index);
 		int GetNestingLevel(void);
 		int GetNewLocalComponentIndex(void);
 		int GetLocalComponentCount(void);
 		int GetInPinCount(void);
 		void AppendChildPropagationIdentifier(const int propagation_identifier);
 		void QueueToPropagate(const int propagation_identifier);
+		// Gate evaluation is only deferred when enough Gates are likely to be Set() to make batching worthwhile, and never
+		// for a Gate that is still waiting to propagate this sub-tick (it must propagate it's new output state).
+		// Defined here so that it can be inlined into Gate::Set().
+		bool CanDeferGateEvaluation(const int propagation_identifier) {
+			return (m_defer_gate_evaluation && (m_propagate_stamps[propagation_identifier] != m_propagate_epoch));
+		}
+		void DeferGateEvaluation(Gate* gate_pointer);
+		void SetPropagateEpoch(const unsigned int new_propagate_epoch);
 		void PrintInternalPinStates(int max_levels);
+		int ReportUnknownPins(const bool name_each_pin);
 		void MarkInnerTerminalsDisconnected(void);
 		Component* SearchForComponentPointer(std::string const& target_component_full_name);
 		void PurgeChildConnections(Component* target_component_pointer);
 		void PurgeChildComponent(std::string const& target_component_name);
 		void PurgeAllChildComponents(void);
 		void PurgeChildComponentIdentifiers(Component* target_component_pointer);
-		void CreateChildFlags(void);
+		void CreateChildFlags(const int local_component_index);
 		bool GetDeletionFlag(void);
 		int GetMessageBranchID(void);
+		void RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map);
+		void AssignSolvePartitions(const int partition_count);
+		void UpdateSolveCosts(const double smoothing);
+		void ChooseParallelSubtrees(const int partition_count, const bool allow_nesting, const double min_parallel_gain);
+		void SolvePartition(const int partition_index);
+		int CountSubtreeComponents(void);
+		void CollectChangedInPins(std::vector<boundary_pin_message>& boundary_pin_messages, const int tick_index);
+		void SaveState(std::vector<unsigned char>& state_buffer, const bool include_children);
+		unsigned char const* RestoreState(unsigned char const* state_pointer, const bool include_children);
+		
+		template <class logging_policy> void SetLogic(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+		
+		static void DeleteComponent(Component* target_component_pointer);
+		template <class logging_policy> static void BroadcastSet(std::vector<device_connection_descriptor> const& targets, const bool state_to_set);
 		
 	private:
 		// Device class private methods.
-		void SubTick(const int index);
+		template <class logging_policy> void SolveWithPolicy(const bool threaded_solve, const int branch_id);
+		template <class logging_policy> void SubTick(const int index);
+		void SolvePendingChildDevices(void);
+		void SolveChildDeviceBatch(const int first_order_index, const int last_order_index);
+		double EstimateSolveWork(void);
+		void SolveAsParallelChild(void);
+		void MarkPinChanged(pin& target_pin);
+		template <class logging_policy> void PropagateChangedPins(std::vector<int>& changed_pin_port_indices, const bool input_pins_flag);
+		void RenumberPropagateStamps(const unsigned int new_propagate_epoch);
+		void RelocateChildGates(void);
+		template <class logging_policy> void EvaluateDeferredGates(void);
+		bool CheckForOscillation(const int index);
+		void UpdateOscillationHash(const int local_component_index);
+		std::string DescribeOscillation(void);
+		void DerivePropagationBudget(void);
 		
 		std::vector<component_descriptor> m_components;
 		std::vector<int> m_devices;
-		std::mutex m_propagation_lock;
+		VoidMPSCQueue<int> m_child_propagation_queue;						// See AppendChildPropagationIdentifier().
 		std::vector<int> m_propagate_next_tick = {};
-		std::vector<bool> m_propagate_next_tick_flags = {};
 		std::vector<int> m_propagate_this_tick = {};
-		std::vector<bool> m_propagate_this_tick_flags = {};
+		// A child Component is queued to propagate next sub-tick if it's stamp is m_propagate_epoch + 1, and is
+		// queued but not yet propagated this sub-tick if it's stamp is m_propagate_epoch. See SubTick().
+		std::vector<unsigned int> m_propagate_stamps = {};
+		unsigned int m_propagate_epoch = 3;
 		bool m_buffered_propagation = false;
 		bool m_solve_this_tick_flag = false;
 		std::vector<int> m_solve_this_tick = {};
+		std::vector<int> m_solve_order = {};
+		std::vector<int> m_offload_order = {};								// Pending child Devices handed to worker threads.
+		solve_event_buffer m_solve_events;									// See SolveAsParallelChild().
+		std::vector<std::string const*> m_solve_order_types = {};
 		std::vector<std::vector<connection_descriptor>> m_ports; 			// Maps in- and out-pins to connection descriptors.
+		std::vector<fanout_descriptor> m_port_fanouts;						// Typed copies of m_ports used by Propagate().
+		std::vector<int> m_changed_in_pins = {};							// Port indices of in pins with state_changed set.
+		std::vector<int> m_changed_out_pins = {};							// Port indices of out pins with state_changed set.
 		const std::vector<std::string> m_hidden_in_pins = {"true", "false"};
 		const std::vector<std::string> m_hidden_out_pins = {"all_stop"};
 		std::vector<state_descriptor> m_in_pin_default_states;
 		int m_message_branch_id = 0;
-		bool m_solve_children_in_own_threads = false;
+		bool m_building_children_in_parallel = false;						// See AddComponentsInParallel().
+		int m_solve_partition = 0;											// Persistent worker that Solve()s this Device, see AssignSolvePartitions().
+		double m_solve_cost = 0.0;											// Smoothed Solve() time per tick in ns, see UpdateSolveCosts().
+		double m_solve_cost_accumulator = 0.0;
+		// Inline versus offloaded threaded Solve(), see EstimateSolveWork().
+		bool m_solve_inline_flag = false;
+		int m_solve_work = 0;												// Child Components propagated by the last Solve(), including child Devices.
+		double m_solve_work_estimate = 0.0;
+		const double m_solve_work_smoothing = 0.25;
+		void* m_gate_block = 0;
+		std::vector<Gate*> m_deferred_gates = {};
+		std::vector<gate_batch> m_gate_batches = std::vector<gate_batch>(GATE_OPERATOR_COUNT);
+		std::vector<unsigned char> m_deferred_results = {};
+		const size_t m_min_gate_batch_size = 16;
+		bool m_defer_gate_evaluation = false;
+		bool m_gates_relocated_flag = false;
+		// Oscillation detection, see CheckForOscillation().
+		int m_oscillation_check_threshold;									// Sub-tick from which Solve() looks for a repeating state.
+		uint64_t m_oscillation_hash = 0;									// XOR of the per-child hashes below.
+		std::vector<uint64_t> m_oscillation_child_hashes = {};
+		std::vector<int> m_oscillation_last_queue = {};
+		uint64_t m_oscillation_fingerprint = 0;
+		int m_oscillation_power = 1;
+		int m_oscillation_steps = 0;
+		int m_oscillation_period = 0;
+		std::vector<int> m_oscillation_components = {};
 		
 	protected:
+		// Copies only this Device's own state, see Simulation::Clone().
+		Device(Device const& original_device) = default;
+		
 		// Device class protected methods.
 		void Solve(const bool threaded_solve, const int branch_id);
 		void QueueToSolve(const int local_component_identifier);
 		void PropagateInputs(void);
+		void CloneChildComponents(std::unordered_map<Component*, Component*>& pointer_map);
+		void RemapSubtreeConnections(std::unordered_map<Component*, Component*> const& pointer_map);
 		
 		int m_max_propagations;
+		int m_configured_max_propagations;			// As passed to (or defaulted by) the constructor, see DerivePropagationBudget().
+		bool m_explicit_max_propagations_flag;
 		bool m_deletion_flag = false;
+		bool m_solve_children_in_own_threads = false;
 		bool m_magic_device_flag = false;
 		MagicEngine* m_magic_engine_pointer;
 		std::vector<bool> m_magic_pin_flag;
 };
 
+// Copy of a built Device sub-class, made by Simulation::Clone(). Once built, a Device's behaviour lives entirely in the
+// base Device, so every cloned Device is of this type (keeping the original's component type).
+class ClonedDevice final : public Device {
+	public:
+		ClonedDevice(Device const& original_device, Device* parent_device_pointer);
+		
+		// Override Device virtual methods.
+		void Build(void) override;
+};
+
 // Top-level Simulation Device sub-class.
 class Simulation : public Device {
 	public:
@@ -236,6 +352,13 @@ class Simulation : public Device {
 		// Override Device virtual methods.
 		void Build(void) override;
 		
+		Simulation* Clone(void);
+		std::vector<branch_result> Branch(const int branch_count, std::function<void(Simulation*, const int)> const& branch_function,
+			std::vector<std::string> const& probe_names, const size_t result_capacity = (1 << 22)
+		);
+		std::vector<std::vector<std::vector<bool>>> RunPartitioned(const int number_of_ticks, const int partition_count, const int optimistic_window = 0,
+			const size_t result_capacity = (1 << 22)
+		);
 		void Run(int number_of_ticks = 0, bool restart_flag = true, bool verbose_debug_flag = false, bool print_probes_flag = false, bool force_no_messages = false);
 		void AddClock(std::string const& clock_name, std::vector<bool> const& toggle_pattern, bool monitor_on);
 		void ClockConnect(std::string const& target_clock_name, std::string const& target_component_name, std::string const& target_terminal_name);
@@ -245,6 +368,9 @@ class Simulation : public Device {
 		void AddToMagicEngines(std::string const& magic_engine_identifier, MagicEngine* magic_engine_pointer);
 		int GetTopLevelMaxPropagations(void);
 		int GetNewCUID(void);
+		void SetSeed(const uint64_t seed);
+		uint64_t GetSeed(void);
+		bool GetRandomBool(void);
 		Clock* GetClockPointer(std::string const& target_clock_name);
 		bool IsSimulationRunning(void);
 		void StopSimulation(void);
@@ -261,17 +387,64 @@ class Simulation : public Device {
 		void PurgeClockDescriptorFromSimulation(Clock* target_clock_pointer);
 		void PurgeMagicEngineDescriptorFromSimulation(magic_engine_descriptor target_descriptor);
 		void PurgeGlobalComponent(std::string const& target_component_full_name);
+		void RemapComponentPointers(std::unordered_map<Component*, Component*> const& pointer_map);
 		bool GetSearchingFlag(void);
 		void SetSearchingFlag(bool value);
 		void PrintErrorMessages(void);
 		void PrintAndClearMessages(void);
 		
+		// Verbose output, or any monitored Component, selects the verbose_logging instantiation of the solver.
+		bool UseVerboseLogging(void) {
+			return (m_verbose_flag || (m_monitored_component_count > 0));
+		}
+		
+		// Output flags belong to the Simulation, so that independent Simulations can run side by side.
+		bool m_verbose_flag = false;
+		bool m_verbose_destructor_flag = false;
+		std::atomic<int> m_monitored_component_count{0};
+		
+		// Where LogMessage() and LogError() on this thread go while a child Device is solved in parallel, otherwise null.
+		static thread_local solve_event_buffer* mg_solve_event_buffer;
+		// The child being built on this thread by Device::AddComponentsInParallel(), otherwise null.
+		static thread_local elaboration_slot* mg_elaboration_slot;
+		
 		VoidThreadPool* m_thread_pool_pointer = 0;
 		bool m_use_threaded_solver;
 		int m_threaded_solve_nesting_level;
+		bool m_use_unknown_states = false;
+		// Persistent worker mode, see StartPersistentWorkers().
+		bool m_use_persistent_workers = false;
+		bool m_persistent_workers_running = false;
+		VoidSpinBarrier* m_solve_barrier_pointer = 0;
+		Device* m_partitioned_solve_device_pointer = 0;
+		// Cost model, see UpdateCostModel().
+		bool m_use_cost_model = false;
+		bool m_profiling_solve_costs = false;
+		bool m_use_parallel_build = false;
+		double m_min_offload_work = 128.0;									// See Device::EstimateSolveWork().
+		// Partitioned runs, see RunPartitioned(). Set only in the process running a partition.
+		std::vector<bool> m_remote_child_flags;
+		std::vector<int> m_boundary_device_indices;
 				
 	private:
+		Simulation(Simulation const& original_simulation);
+		
 		void EnableTerminalRawIO(const bool raw_flag);
+		void StartPersistentWorkers(void);
+		void StopPersistentWorkers(void);
+		void PersistentWorkerLoop(const int partition_index);
+		void RunPartition(const int partition_index, const int partition_count, const int number_of_ticks, const int optimistic_window,
+			std::vector<int> const& device_partitions, VoidSharedSpinBarrier* barrier_pointer, std::atomic<int>* shared_flags,
+			std::vector<VoidSPSCRing<boundary_pin_message>*> const& rings
+		);
+		void RunPartitionOptimistically(const int partition_index, const int partition_count, const int number_of_ticks, const int optimistic_window,
+			std::vector<Device*> const& device_pointers, std::vector<int> const& device_partitions, VoidSharedSpinBarrier* barrier_pointer,
+			std::atomic<int>* shared_flags, std::vector<VoidSPSCRing<boundary_pin_message>*> const& rings
+		);
+		void SavePartitionState(std::vector<unsigned char>& state_buffer);
+		void RestorePartitionState(std::vector<unsigned char> const& state_buffer);
+		void UpdateCostModel(void);
+		void CollectLoggedMessages(void);
 		char CheckForCharacter(void);
 		
 		std::vector<probe_descriptor> m_probes;
@@ -279,12 +452,20 @@ class Simulation : public Device {
 		std::vector<magic_engine_descriptor> m_magic_engines;
 		std::vector<std::string> m_error_messages;
 		std::vector<std::string> m_messages;
-		termios m_old_term_io_settings;
-		bool m_simulation_running;
+		std::atomic<bool> m_simulation_running;
 		int m_global_tick_index;
-		int m_next_new_CUID;
+		std::atomic<int> m_next_new_CUID;
+		uint64_t m_seed;
+		xoshiro256_generator m_random_generator;
 		bool m_searching_flag = false;
-		std::mutex m_sim_lock;
+		// Messages and errors logged outside of a parallel child solve in threaded mode, see CollectLoggedMessages().
+		VoidMPSCQueue<std::string> m_logged_messages;
+		VoidMPSCQueue<std::string> m_logged_error_messages;
+		void_job_group m_persistent_worker_group;
+		int m_cost_model_ticks_profiled = 0;
+		const int m_cost_model_warmup_ticks = 32;
+		const double m_solve_cost_smoothing = 0.25;
+		double m_min_parallel_gain = 50000.0;				// ns of child Solve() time per tick that must overlap the largest child.
 };
 
 // Clock utility class.
@@ -300,17 +481,23 @@ class Clock {
 		void Reset(void);
 		void AddToProbeList(std::string const& probe_identifier, Probe* probe_pointer);
 		void TriggerProbes(void);
+		void RewindTo(const int tick_index);
 		bool GetTickedFlag(void);
 		void PurgeTargetComponentConnections(Component* target_component_pointer);
+		void RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map);
+		Clock* CloneInto(Simulation* top_level_sim_pointer);
 		void PurgeClock(void);
 		void PurgeProbeDescriptorFromClock(Probe* target_probe_pointer);
 
 	private:
+		template <class logging_policy> void PropagateToTargets(void);
+		
 		Simulation* m_top_level_sim_pointer;
 		std::string m_name;
 		std::vector<bool> m_toggle_pattern;
 		bool m_monitor_on;
 		std::vector<connection_descriptor> m_connections;
+		fanout_descriptor m_fanout;
 		bool m_out_pin_state;
 		std::vector<bool> m_state_history;
 		size_t m_index;
@@ -330,7 +517,10 @@ class Probe {
 		void PreallocateSampleMemory(int number_of_ticks);
 		void Sample(const int index);
 		void Reset(void);
+		void DiscardSamplesFrom(const int tick_index);
 		Component* GetTargetComponentPointer(void);
+		void RemapTargetComponentPointer(std::unordered_map<Component*, Component*> const& pointer_map);
+		Probe* CloneInto(Simulation* top_level_sim_pointer, std::unordered_map<Clock*, Clock*> const& clock_pointer_map);
 		void PrintSamples(void);
 		std::vector<std::vector<bool>> GetSamples(void);
 		void PurgeProbe(void);
@@ -347,7 +537,9 @@ class Probe {
 		int m_probe_every_n_ticks;
 		std::vector<int> m_timestamps;
 		std::vector<std::vector<bool>> m_samples;
+		std::unordered_map<size_t, std::vector<bool>> m_unknown_samples;		// Unknown flags by sample index, see Sample().
 		std::vector<bool> m_this_sample;
+		std::vector<bool> m_this_unknown_sample;
 		std::vector<std::string> m_output_characters = {};
 };
 
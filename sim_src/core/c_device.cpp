@@ -24,8 +24,11 @@
 #include <vector>					// std::vector
 #include <algorithm>				// std::sort
 #include <thread>					// std::thread
-#include <mutex>					// std::mutex, std::unique_lock
 #include <functional>				// std::bind
+#include <limits>					// std::numeric_limits
+#include <new>						// ::operator new, ::operator delete
+#include <unordered_map>			// std::unordered_map
+#include <chrono>					// std::chrono::steady_clock
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
@@ -40,31 +43,42 @@ Device::Device(Device* parent_device_pointer, std::string const& device_name, st
 	std::vector<std::string> out_pin_names, bool monitor_on, std::vector<state_descriptor> in_pin_default_states, int max_propagations
 	) {
 	m_device_flag = true;
-	m_name = device_name;
+	m_name = GetSharedName(device_name);
 	m_parent_device_pointer = parent_device_pointer;
 	if (m_parent_device_pointer == this) {
 		// The instantiating component is only the same as it's parent component when it is the top-level Simulation.
 		m_top_level_sim_pointer = static_cast<Simulation*>(m_parent_device_pointer);
 		m_CUID = 0;						// Top-level simulation always CUID 0.
 		m_nesting_level = 0;			// "" nesting_level 0
-		m_full_name = m_name;
+		m_full_name = *m_name;
 	} else {
 		m_top_level_sim_pointer = m_parent_device_pointer->GetTopLevelSimPointer();
 		m_CUID = m_top_level_sim_pointer->GetNewCUID();
 		m_local_component_index = m_parent_device_pointer->GetNewLocalComponentIndex();
 		m_nesting_level = m_parent_device_pointer->GetNestingLevel() + 1;
-		m_full_name = m_parent_device_pointer->GetFullName() + ":" + m_name;
-		m_parent_device_pointer->CreateChildFlags();
+		m_full_name = m_parent_device_pointer->GetFullName() + ":" + *m_name;
+		m_parent_device_pointer->CreateChildFlags(m_local_component_index);
 	}
-	m_component_type = device_type;
+	m_component_type = GetSharedName(device_type);
 	m_monitor_on = monitor_on;
-	m_solve_children_in_own_threads = (m_top_level_sim_pointer->m_use_threaded_solver && (m_nesting_level == m_top_level_sim_pointer->m_threaded_solve_nesting_level));
+	if (m_monitor_on) {
+		m_top_level_sim_pointer->m_monitored_component_count ++;
+	}
+	// With the cost model on, everything is solved on the calling thread until it has chosen (see ChooseParallelSubtrees()).
+	m_solve_children_in_own_threads = (m_top_level_sim_pointer->m_use_threaded_solver && !m_top_level_sim_pointer->m_use_cost_model
+		&& (m_nesting_level == m_top_level_sim_pointer->m_threaded_solve_nesting_level));
 	if (max_propagations == 0) {
 		// If default max_propagations get the value from the top-level simulation.
 		m_max_propagations = m_top_level_sim_pointer->GetTopLevelMaxPropagations();
 	} else {
 		m_max_propagations = max_propagations;
 	}
+	// The top-level Simulation's value is the default for every Device, so is not treated as explicit for itself.
+	m_configured_max_propagations = m_max_propagations;
+	m_explicit_max_propagations_flag = ((max_propagations != 0) && (m_parent_device_pointer != this));
+	// Oscillation detection is left for the second half of the propagation budget, so that the common case of a
+	// Device settling in a few sub-ticks costs nothing. Both are refined by DerivePropagationBudget().
+	m_oscillation_check_threshold = m_max_propagations / 2;
 	std::sort(in_pin_names.begin(), in_pin_names.end(), compareNat);
 	// Utility 'hidden' in and out pins have to be created by the base Device constructor.
 	// Further calls by Devices inheriting the base class won't include these.
@@ -76,16 +90,33 @@ Device::Device(Device* parent_device_pointer, std::string const& device_name, st
 }
 
 Device::~Device() {
+	if (m_monitor_on) {
+		m_top_level_sim_pointer->m_monitored_component_count --;
+	}
 	PurgeComponent();
-	if (mg_verbose_destructor_flag) {
+	// All child Gates have been destroyed by now, so we can release the memory that the relocated ones lived in.
+	if (m_gate_block != 0) {
+		::operator delete(m_gate_block);
+	}
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		std::cout << "Device dtor for " << m_full_name << " @ " << this << std::endl;
 	}
 }
 
-void Device::CreateChildFlags() {
-	// Create un-set propagation flags for a new child Device.
-	m_propagate_next_tick_flags.push_back(false);
-	m_propagate_this_tick_flags.push_back(false);
+void Device::DeleteComponent(Component* target_component_pointer) {
+	// Relocated Gates live in their parent Device's Gate block, so are destroyed in place rather than deleted.
+	if (target_component_pointer->GetRelocatedFlag()) {
+		target_component_pointer->~Component();
+	} else {
+		delete target_component_pointer;
+	}
+}
+
+void Device::CreateChildFlags(const int local_component_index) {
+	// Create an un-set propagation stamp for a new child Component (unless AddComponentsInParallel() has reserved it).
+	if (local_component_index == int(m_propagate_stamps.size())) {
+		m_propagate_stamps.push_back(0);
+	}
 }
 
 void Device::CreateInPins(std::vector<std::string> const& pin_names, std::vector<state_descriptor> pin_default_states) {
@@ -93,10 +124,11 @@ void Device::CreateInPins(std::vector<std::string> const& pin_names, std::vector
 	int new_pin_port_index = m_pins.size();
 	// Create new inputs.
 	for (const auto& pin_name: pin_names) {
-		pin new_in_pin = {pin_name, 1, false, false, new_pin_port_index, {false, false}};
+		pin new_in_pin = {GetSharedName(pin_name), 1, false, false, new_pin_port_index, {false, false}, false};
 		SetPin(new_in_pin, pin_default_states);
 		m_pins.push_back(new_in_pin);
 		m_ports.push_back({});
+		m_port_fanouts.push_back({});
 		new_pin_port_index ++;
 	}
 }
@@ -106,10 +138,11 @@ void Device::CreateOutPins(std::vector<std::string> const& pin_names) {
 	int new_pin_port_index = m_pins.size();
 	// Create new outputs.
 	for (const auto& pin_name : pin_names) {
-		pin new_out_pin = {pin_name, 2, false, false, new_pin_port_index, {false, false}};
+		pin new_out_pin = {GetSharedName(pin_name), 2, false, false, new_pin_port_index, {false, false}, false};
 		SetPin(new_out_pin, {});
 		m_pins.push_back(new_out_pin);
 		m_ports.push_back({});
+		m_port_fanouts.push_back({});
 		new_pin_port_index ++;
 	}
 }
@@ -132,11 +165,12 @@ void Device::CreateBus(int pin_count, std::string const& pin_name_prefix, int pi
 
 void Device::SetPin(pin& target_pin, std::vector<state_descriptor> pin_default_states) {
 	// SetPin() only sets pin logical state & state_changed flag for input and output (direction = 1 or 2) pins.
-	std::string pin_name = target_pin.name;
+	std::string const& pin_name = *target_pin.name;
 	if (IsStringInVector(pin_name, m_hidden_in_pins)) {
 		// If hidden in pin, set direction and state accordingly...
 		target_pin.direction = 3;
-		target_pin.state_changed = true;
+		target_pin.unknown = false;
+		MarkPinChanged(target_pin);
 		if (pin_name == "true") {
 			target_pin.state = true;
 		} else if (pin_name == "false") {
@@ -147,17 +181,33 @@ void Device::SetPin(pin& target_pin, std::vector<state_descriptor> pin_default_s
 		target_pin.direction = 4;
 		target_pin.state_changed = false;
 		target_pin.state = false;
+		target_pin.unknown = false;
 	} else {
 		// If this is a user-defined input, handle as normal.
 		std::vector<bool> result = IsStringInStateDescriptorVector(pin_name, pin_default_states);
 		if (result[0]) {
 			// If this input is in the defaults list set accordingly...
 			target_pin.state = result[1];
+			target_pin.unknown = false;
 		} else {
-			// ...otherwise set input state to false.
+			// ...otherwise set input state to false (or X if the Simulation is using unknown states).
 			target_pin.state = false;
+			target_pin.unknown = m_top_level_sim_pointer->m_use_unknown_states;
 		}
+		MarkPinChanged(target_pin);
+	}
+}
+
+void Device::MarkPinChanged(pin& target_pin) {
+	// Flag the pin as changed and, if it is not already flagged, add it to the relevant changed pins list so that
+	// PropagateInputs() and Propagate() do not have to scan every pin on the Device.
+	if (!target_pin.state_changed) {
 		target_pin.state_changed = true;
+		if ((target_pin.direction == 1) || (target_pin.direction == 3)) {
+			m_changed_in_pins.push_back(target_pin.port_index);
+		} else if (target_pin.direction == 2) {
+			m_changed_out_pins.push_back(target_pin.port_index);
+		}
 	}
 }
 
@@ -198,27 +248,42 @@ void Device::Reset() {
 
 void Device::Stabilise() {
 	// Ensures that internal device state settles correctly.
-	if (mg_verbose_flag) {
+	if (m_top_level_sim_pointer->m_verbose_flag) {
 		std::string message = GenerateHeader("Stabilising new level " + std::to_string(m_nesting_level) + " Device " + m_full_name);
 		m_top_level_sim_pointer->LogMessage(message + "\n");
 	}
+	// Size the propagation budget from the structure of the Device's child Component graph.
+	DerivePropagationBudget();
 	// First we call Initialise() for all Components to set their out pins state_changed flags to true and
 	// add their local ids to this Device's propagate next vector.
 	for (const auto& this_component_descriptor : m_components) {
-			if (mg_verbose_flag) {
-				std::string message = "Initialising " + this_component_descriptor.component_full_name + "...";
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = "Initialising " + this_component_descriptor.component_pointer->GetFullName() + "...";
 				m_top_level_sim_pointer->LogMessage(message);
 			}
 			this_component_descriptor.component_pointer->Initialise();
 	}
 	// Then we call Solve() for this Device.
 	Solve(false, 0);
-	if (mg_verbose_flag) {
+	// Any out pin changes buffered during the Solve() need to be propagated by the parent Device.
+	if ((this != m_top_level_sim_pointer) && m_buffered_propagation) {
+		m_buffered_propagation = false;
+		m_parent_device_pointer->AppendChildPropagationIdentifier(m_local_component_index);
+	}
+	// The first time the Device is stabilised it's child Gates are moved into contiguous memory.
+	if (!m_gates_relocated_flag) {
+		m_gates_relocated_flag = true;
+		RelocateChildGates();
+	}
+	if (m_top_level_sim_pointer->m_verbose_flag) {
 		std::string message = "\n" + GenerateHeader("Starting state settled.") + "\n";
 		m_top_level_sim_pointer->LogMessage(message);
 	}
 	if (this == m_top_level_sim_pointer) {
 		ReportUnConnectedPins();
+		if (m_top_level_sim_pointer->m_use_unknown_states) {
+			ReportUnknownPins(m_top_level_sim_pointer->m_verbose_flag);
+		}
 		std::string message = "\n" + GenerateHeader("Simulation build completed.");
 		m_top_level_sim_pointer->LogMessage(message);
 		m_top_level_sim_pointer->PrintAndClearMessages();
@@ -234,18 +299,15 @@ void Device::Initialise() {
 	// all need to be propagated so that they 'overwrite' the initial random build-time Gate inputs.
 	for (auto& this_pin : m_pins) {
 		if (this_pin.direction == 2) {
-			this_pin.state_changed = true;
+			MarkPinChanged(this_pin);
 		}
 	}
 	m_parent_device_pointer->AppendChildPropagationIdentifier(m_local_component_index);
 }
 
 void Device::AddComponent(Component* new_component_pointer) {
-	std::string new_component_name = new_component_pointer->GetName();
-	std::string new_component_full_name = new_component_pointer->GetFullName();
 	component_descriptor new_component_descriptor;
-	new_component_descriptor.component_name = new_component_name;
-	new_component_descriptor.component_full_name = new_component_full_name;
+	new_component_descriptor.component_name = GetSharedName(new_component_pointer->GetName());
 	new_component_descriptor.component_pointer = new_component_pointer;
 	m_components.push_back(new_component_descriptor);
 	// Keep an additional vector of the local component indices of Device Components so that we don't
@@ -255,6 +317,135 @@ void Device::AddComponent(Component* new_component_pointer) {
 	}
 }
 
+bool Device::AddComponentsInParallel(std::vector<std::function<Component*()>> const& component_builders) {
+	// Each builder must construct (and return) exactly one child Component of this Device, which must not touch
+	// anything outside it's own subtree while it is built - so no Clocks, Probes or magic Devices. Siblings are only
+	// wired together once they have all been built and stabilised. Without parallel builds the children are built
+	// one after another here, exactly as if they had been added with AddComponent(). Returns false (having logged
+	// an error and left out the failed children) if any builder did not build exactly one child.
+	int component_count = component_builders.size();
+	if (!m_top_level_sim_pointer->m_use_parallel_build || (component_count < 2)) {
+		bool all_built_flag = true;
+		for (int i = 0; i < component_count; i ++) {
+			Component* new_component_pointer = component_builders[i]();
+			if (new_component_pointer == 0) {
+				std::string build_error = "Device " + m_full_name + " parallel builder " + std::to_string(i) + " did not build exactly one child Component.";
+				m_top_level_sim_pointer->LogError(build_error);
+				all_built_flag = false;
+				continue;
+			}
+			AddComponent(new_component_pointer);
+		}
+		return all_built_flag;
+	}
+	// Reserve the children's local component indices and propagation stamps up front and in order, so they are
+	// numbered as if they had been built one after another.
+	int first_local_component_index = m_components.size();
+	m_components.resize(first_local_component_index + component_count, {0, 0});
+	m_propagate_stamps.resize(first_local_component_index + component_count, 0);
+	// Each slot's random stream depends only on the seed, this Device's name and the child's index.
+	uint64_t parent_seed = MixHash(m_top_level_sim_pointer->GetSeed() ^ std::hash<std::string>{}(m_full_name));
+	std::vector<elaboration_slot> slots(component_count);
+	for (int i = 0; i < component_count; i ++) {
+		slots[i].parent_device_pointer = this;
+		slots[i].local_component_index = first_local_component_index + i;
+		slots[i].component_pointer = 0;
+		slots[i].random_generator.Seed(MixHash(parent_seed ^ uint64_t(slots[i].local_component_index)));
+	}
+	// Stabilised children notify this Device of buffered out pin changes from their worker threads.
+	m_building_children_in_parallel = true;
+	VoidThreadPool* thread_pool_pointer = m_top_level_sim_pointer->m_thread_pool_pointer;
+	void_job_group build_group;
+	for (int i = 0; i < component_count; i ++) {
+		elaboration_slot* slot_pointer = &slots[i];
+		std::function<Component*()> const* builder_pointer = &component_builders[i];
+		thread_pool_pointer->AddJob(build_group, [slot_pointer, builder_pointer]() {
+			// Nested parallel builds may run on this thread while it waits, so restore rather than clear.
+			elaboration_slot* outer_slot_pointer = Simulation::mg_elaboration_slot;
+			solve_event_buffer* outer_event_buffer = Simulation::mg_solve_event_buffer;
+			Simulation::mg_elaboration_slot = slot_pointer;
+			Simulation::mg_solve_event_buffer = &slot_pointer->events;
+			slot_pointer->component_pointer = (*builder_pointer)();
+			Simulation::mg_elaboration_slot = outer_slot_pointer;
+			Simulation::mg_solve_event_buffer = outer_event_buffer;
+		});
+	}
+	thread_pool_pointer->WaitForJobs(build_group);
+	m_building_children_in_parallel = false;
+	// Fill in the reserved descriptors, and merge build messages, in index order.
+	std::vector<Component*> misplaced_component_pointers;
+	for (auto& this_slot : slots) {
+		for (const auto& this_message : this_slot.events.messages) {
+			m_top_level_sim_pointer->LogMessage(this_message);
+		}
+		for (const auto& this_error_message : this_slot.events.error_messages) {
+			m_top_level_sim_pointer->LogError(this_error_message);
+		}
+		Component* new_component_pointer = this_slot.component_pointer;
+		if ((new_component_pointer == 0) || (new_component_pointer->GetLocalComponentIndex() != this_slot.local_component_index)) {
+			// Log build error here.		-- Builder did not construct exactly one child of this Device!
+			std::string build_error = "Device " + m_full_name + " parallel builder " + std::to_string(this_slot.local_component_index - first_local_component_index) + " did not build exactly one child Component.";
+			m_top_level_sim_pointer->LogError(build_error);
+			if (new_component_pointer != 0) {
+				misplaced_component_pointers.push_back(new_component_pointer);
+			}
+			continue;
+		}
+		component_descriptor& new_component_descriptor = m_components[this_slot.local_component_index];
+		new_component_descriptor.component_name = GetSharedName(new_component_pointer->GetName());
+		new_component_descriptor.component_pointer = new_component_pointer;
+	}
+	// Drop the descriptors of any failed builders (Stabilise() can not run over them) and close up the gaps, so the
+	// Components that did build keep the same order they would have had if built one after another.
+	std::vector<int> new_local_component_indices(component_count, -1);
+	int next_local_component_index = first_local_component_index;
+	for (int i = 0; i < component_count; i ++) {
+		component_descriptor this_component_descriptor = m_components[first_local_component_index + i];
+		if (this_component_descriptor.component_pointer == 0) {
+			continue;
+		}
+		if (next_local_component_index != (first_local_component_index + i)) {
+			m_components[next_local_component_index] = this_component_descriptor;
+			this_component_descriptor.component_pointer->SetLocalComponentIndex(next_local_component_index);
+		}
+		new_local_component_indices[i] = next_local_component_index;
+		if (this_component_descriptor.component_pointer->GetDeviceFlag()) {
+			m_devices.push_back(next_local_component_index);
+		}
+		next_local_component_index ++;
+	}
+	m_components.resize(next_local_component_index);
+	m_propagate_stamps.resize(next_local_component_index);
+	if (next_local_component_index == (first_local_component_index + component_count)) {
+		return true;
+	}
+	// Children that stabilised while being built may have queued their old indices (or, if misplaced, indices past
+	// the reserved ones) for propagation.
+	std::vector<int> queued_propagation_identifiers;
+	m_child_propagation_queue.Drain([&queued_propagation_identifiers](int propagation_identifier) {
+		queued_propagation_identifiers.push_back(propagation_identifier);
+	});
+	for (const auto& this_propagation_identifier : queued_propagation_identifiers) {
+		int new_propagation_identifier = this_propagation_identifier;
+		if (this_propagation_identifier >= (first_local_component_index + component_count)) {
+			new_propagation_identifier = -1;
+		} else if (this_propagation_identifier >= first_local_component_index) {
+			new_propagation_identifier = new_local_component_indices[this_propagation_identifier - first_local_component_index];
+		}
+		if (new_propagation_identifier >= 0) {
+			m_child_propagation_queue.Push(new_propagation_identifier);
+		}
+	}
+	// A child built at the wrong index was never given a descriptor, so nothing refers to it. Setting the deletion
+	// flag stops it from trying to tidy itself out of this Device as it is destroyed.
+	m_deletion_flag = true;
+	for (const auto& this_component_pointer : misplaced_component_pointers) {
+		DeleteComponent(this_component_pointer);
+	}
+	m_deletion_flag = false;
+	return false;
+}
+
 void Device::AddGate(std::string const& component_name, std::string const& component_type, std::vector<std::string> const& in_pin_names, bool monitor_on) {
 	AddComponent(new Gate(this, component_name, component_type, in_pin_names, monitor_on));
 }
@@ -321,14 +512,22 @@ void Device::ChildSet(std::string const& target_child_component_name, std::strin
 	} else {
 		int target_pin_port_index = target_component_pointer->GetPinPortIndex(target_pin_name);
 		bool target_component_monitor_on_flag = target_component_pointer->GetMonitorOnFlag();
-		if (mg_verbose_flag || target_component_monitor_on_flag) {
+		if (m_top_level_sim_pointer->m_verbose_flag || target_component_monitor_on_flag) {
 			std::cout << std::endl << BOLD(FYEL("CHILDSET: ")) << "Component " << BOLD("" << target_component_pointer->GetFullName() << ":" << target_component_pointer->GetComponentType() << "") << " terminal " << BOLD("" << target_pin_name << "") << " set to " << BoolToChar(logical_state) << std::endl;
 		}
-		if (mg_verbose_flag) {
+		if (m_top_level_sim_pointer->m_verbose_flag) {
 			m_top_level_sim_pointer->LogMessage("~S0");
 		}
 		target_component_pointer->Set(target_pin_port_index, logical_state);
-		if (mg_verbose_flag) {
+		// In case a child Gate deferred it's evaluation, evaluate it now.
+		if (m_deferred_gates.size() > 0) {
+			if (m_top_level_sim_pointer->UseVerboseLogging()) {
+				EvaluateDeferredGates<verbose_logging>();
+			} else {
+				EvaluateDeferredGates<quiet_logging>();
+			}
+		}
+		if (m_top_level_sim_pointer->m_verbose_flag) {
 			m_top_level_sim_pointer->LogMessage("~E0");
 		}
 		// If this is a 1st-level device, if the simulation is not running the user would need to call Solve() after every
@@ -494,6 +693,7 @@ void Device::Connect(std::vector<std::string> connection_parameters) {
 							target_pin_already_driven = target_component_pointer->CheckIfPinDriven(new_connection_descriptor.target_pin_port_index);
 							if (!target_pin_already_driven[0]) {
 								m_ports[origin_pin_port_index].push_back(new_connection_descriptor);
+								BuildFanout(m_ports[origin_pin_port_index], m_port_fanouts[origin_pin_port_index]);
 								target_component_pointer->SetPinDrivenFlag(new_connection_descriptor.target_pin_port_index, false, true);
 								m_pins[origin_pin_port_index].drive[1] = true;
 							}
@@ -555,31 +755,75 @@ void Device::Connect(std::vector<std::string> connection_parameters) {
 }
 
 void Device::Solve(const bool threaded_solve, const int branch_id) {
+	// Solve() is only timed while the cost model is warming up, see Simulation::UpdateCostModel().
+	bool profiling_flag = m_top_level_sim_pointer->m_profiling_solve_costs;
+	std::chrono::steady_clock::time_point solve_start;
+	if (profiling_flag) {
+		solve_start = std::chrono::steady_clock::now();
+	}
+	// Pick the solver instantiation once per Solve(), rather than checking the logging flags throughout.
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		SolveWithPolicy<verbose_logging>(threaded_solve, branch_id);
+	} else {
+		SolveWithPolicy<quiet_logging>(threaded_solve, branch_id);
+	}
+	if (profiling_flag) {
+		m_solve_cost_accumulator += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - solve_start).count();
+	}
+}
+
+template <class logging_policy>
+void Device::SolveWithPolicy(const bool threaded_solve, const int branch_id) {
 	int original_branch_id = m_message_branch_id;
 	if (threaded_solve) {
 		m_message_branch_id = m_CUID;
 	} else {
 		m_message_branch_id = branch_id;	
 	}
-	if (mg_verbose_flag) {
-		// Indicate the start of this solution level to the message handler.
-		m_top_level_sim_pointer->LogMessage("~S" + std::to_string(m_message_branch_id));
-		std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " Propagating inputs...\n" + std::to_string(m_message_branch_id) + ":";
-		m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+	if constexpr (logging_policy::enabled) {
+		if (m_top_level_sim_pointer->m_verbose_flag) {
+			// Indicate the start of this solution level to the message handler.
+			m_top_level_sim_pointer->LogMessage("~S" + std::to_string(m_message_branch_id));
+			std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " Propagating inputs...\n" + std::to_string(m_message_branch_id) + ":";
+			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+		}
 	}
 	// Clear the Solve() pending flag.
 	m_solve_this_tick_flag = false;
+	if (!m_child_propagation_queue.Empty()) {
+		m_child_propagation_queue.Drain([this](int propagation_identifier) {
+			m_propagate_next_tick.emplace_back(propagation_identifier);
+			m_propagate_stamps[propagation_identifier] = m_propagate_epoch + 1;
+		});
+	}
+	m_solve_work = m_changed_in_pins.size();
 	int sub_tick_count = 0;
 	// Propagate Device inputs first.
-	PropagateInputs();
+	size_t input_gate_target_count = 0;
+	for (const auto& this_pin_port_index : m_changed_in_pins) {
+		input_gate_target_count += m_port_fanouts[this_pin_port_index].gate_targets.size();
+	}
+	m_defer_gate_evaluation = (input_gate_target_count >= m_min_gate_batch_size);
+	PropagateChangedPins<logging_policy>(m_changed_in_pins, true);
+	if (m_deferred_gates.size() > 0) {
+		EvaluateDeferredGates<logging_policy>();
+	}
+	m_defer_gate_evaluation = false;
 	while (true) {
-		if (mg_verbose_flag) {
-			std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " starting to Solve()...";
-			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message); 
+		if constexpr (logging_policy::enabled) {
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " starting to Solve()...";
+				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message); 
+			}
 		}
 		// Handle pending propagations for child Gates and child Device out pins.
+		bool oscillation_detected = false;
 		while (sub_tick_count <= m_max_propagations) {
-			SubTick(sub_tick_count);
+			if ((sub_tick_count >= m_oscillation_check_threshold) && CheckForOscillation(sub_tick_count)) {
+				oscillation_detected = true;
+				break;
+			}
+			SubTick<logging_policy>(sub_tick_count);
 			// Terminate loop when there are no pending propagations.
 			if (m_propagate_next_tick.size() > 0) {
 				sub_tick_count ++;
@@ -588,39 +832,40 @@ void Device::Solve(const bool threaded_solve, const int branch_id) {
 				break;
 			}
 		}
-		if (sub_tick_count > m_max_propagations) {
+		if (oscillation_detected || (sub_tick_count > m_max_propagations)) {
 			// Log error here.		-- Not able to stabilise Device state.
-			std::string error_message = "Could not stabilise " + m_full_name + " state within " + std::to_string(m_max_propagations) + " propagation steps.";
+			std::string error_message;
+			if (oscillation_detected) {
+				error_message = "Could not stabilise " + m_full_name + " state, it oscillates with a period of " + std::to_string(m_oscillation_period)
+					+ " propagation steps (detected after " + std::to_string(sub_tick_count) + " steps)." + DescribeOscillation();
+			} else {
+				error_message = "Could not stabilise " + m_full_name + " state within " + std::to_string(m_max_propagations) + " propagation steps.";
+				if (m_oscillation_period > 0) {
+					error_message += " A possible oscillation with a period of " + std::to_string(m_oscillation_period) + " propagation steps was seen." + DescribeOscillation();
+				}
+			}
 			m_top_level_sim_pointer->LogError("~" + std::to_string(m_message_branch_id) + ": " + error_message);
-			if (mg_verbose_flag) {
-				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + error_message);
-				// Indicate the end (for now) of this solution level to the message handler.
-				m_top_level_sim_pointer->LogMessage("~E" + std::to_string(m_message_branch_id));
+			if constexpr (logging_policy::enabled) {
+				if (m_top_level_sim_pointer->m_verbose_flag) {
+					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + error_message);
+					// Indicate the end (for now) of this solution level to the message handler.
+					m_top_level_sim_pointer->LogMessage("~E" + std::to_string(m_message_branch_id));
+				}
 			}
 			break;
 		} else {
-			if (mg_verbose_flag) {
-				std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " Solve()d.";
-				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-				// Indicate the end (for now) of this solution level to the message handler.
-				m_top_level_sim_pointer->LogMessage("~E" + std::to_string(m_message_branch_id));
+			if constexpr (logging_policy::enabled) {
+				if (m_top_level_sim_pointer->m_verbose_flag) {
+					std::string message = std::string("\n") + std::to_string(m_message_branch_id) + ": " + KBLD + KMAG + "Level " + RST + KBLD + std::to_string(m_nesting_level) + RST + " Device " + KBLD + m_full_name + RST + " Solve()d.";
+					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+					// Indicate the end (for now) of this solution level to the message handler.
+					m_top_level_sim_pointer->LogMessage("~E" + std::to_string(m_message_branch_id));
+				}
 			}
 		}
 		// ------------------------------------------------------------------------------------------------------
-		if (!m_solve_children_in_own_threads) {
-			// Regular Solve() for all pending child Devices.
-			for (const auto& this_local_device_index : m_solve_this_tick) {
-				Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
-				this_device_pointer->Solve(false, m_message_branch_id);
-			}
-		} else {	// Experimental multi-threading support -----------------------------------------------------------------------------
-			// Threaded Solve() for all pending child Devices.
-			for (const auto& this_local_device_index : m_solve_this_tick) {
-				Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
-				m_top_level_sim_pointer->m_thread_pool_pointer->AddJob(std::bind(&Device::Solve, this_device_pointer, true, 0));
-			}
-			// Wait until all Device Solve() threads finish.
-			m_top_level_sim_pointer->m_thread_pool_pointer->WaitForAllJobs();
+		if (m_solve_this_tick.size() > 0) {
+			SolvePendingChildDevices();
 		}
 		// ------------------------------------------------------------------------------------------------------
 		m_solve_this_tick.clear();
@@ -630,144 +875,889 @@ void Device::Solve(const bool threaded_solve, const int branch_id) {
 			break;
 		} else {
 			// If we have changes to propagate, indicate to the message handler that we're starting another pass at this level.
-			if (mg_verbose_flag) {
-				m_top_level_sim_pointer->LogMessage("~S" + std::to_string(m_message_branch_id));
+			if constexpr (logging_policy::enabled) {
+				if (m_top_level_sim_pointer->m_verbose_flag) {
+					m_top_level_sim_pointer->LogMessage("~S" + std::to_string(m_message_branch_id));
+				}
 			}
 		}
 	}
 	// If we're solving the top-level Simulation state, we need to check if the Clock has triggered any Probes.
-	if (this == m_top_level_sim_pointer) {
+	// (Buffered out pin changes of a child Device are picked up by the parent in SolvePendingChildDevices()).
+	// In a partitioned run the Probes are only triggered once the partitions have settled the tick between them.
+	if ((this == m_top_level_sim_pointer) && m_top_level_sim_pointer->m_remote_child_flags.empty()) {
 		m_top_level_sim_pointer->CheckProbeTriggers();
-	} else {
-		if (m_buffered_propagation) {
-			m_buffered_propagation = false;
-			m_parent_device_pointer->AppendChildPropagationIdentifier(m_local_component_index);
-		}
 	}
+	m_solve_work_estimate += m_solve_work_smoothing * (m_solve_work - m_solve_work_estimate);
 	m_message_branch_id = original_branch_id;
 }
 
+void Device::SolvePendingChildDevices() {
+	if ((this == m_top_level_sim_pointer) && !m_top_level_sim_pointer->m_remote_child_flags.empty()) {
+		// Partitioned run - top-level Devices owned by other processes are not Solve()d here. They stay flagged as
+		// queued (so further changes only mark their pins) until Simulation::RunPartition() sends their in pin changes on.
+		size_t kept_count = 0;
+		for (const auto& this_local_device_index : m_solve_this_tick) {
+			if (m_top_level_sim_pointer->m_remote_child_flags[this_local_device_index]) {
+				m_top_level_sim_pointer->m_boundary_device_indices.push_back(this_local_device_index);
+			} else {
+				m_solve_this_tick[kept_count] = this_local_device_index;
+				kept_count ++;
+			}
+		}
+		m_solve_this_tick.resize(kept_count);
+		if (kept_count == 0) {
+			return;
+		}
+	}
+	if (!m_solve_children_in_own_threads) {
+		// Regular Solve() for all pending child Devices.
+		for (const auto& this_local_device_index : m_solve_this_tick) {
+			Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
+			this_device_pointer->Solve(false, m_message_branch_id);
+		}
+	} else {	// Experimental multi-threading support -----------------------------------------------------------------------------
+		// Group the pending child Devices by type, in order of first appearance, so that instances of the same Device
+		// are solved back-to-back and can be handed to the thread pool as a few large batches rather than one job per
+		// Device. Type names are shared (see Component::GetSharedName()) so comparing pointers is enough.
+		m_solve_order.clear();
+		m_solve_order_types.clear();
+		for (const auto& this_local_device_index : m_solve_this_tick) {
+			std::string const* this_type = static_cast<Device*>(m_components[this_local_device_index].component_pointer)->m_component_type;
+			bool type_found = false;
+			for (const auto& this_ordered_type : m_solve_order_types) {
+				if (this_ordered_type == this_type) {
+					type_found = true;
+					break;
+				}
+			}
+			if (!type_found) {
+				m_solve_order_types.push_back(this_type);
+			}
+		}
+		if (m_solve_order_types.size() == 1) {
+			m_solve_order = m_solve_this_tick;
+		} else {
+			for (const auto& this_ordered_type : m_solve_order_types) {
+				for (const auto& this_local_device_index : m_solve_this_tick) {
+					if (static_cast<Device*>(m_components[this_local_device_index].component_pointer)->m_component_type == this_ordered_type) {
+						m_solve_order.push_back(this_local_device_index);
+					}
+				}
+			}
+		}
+		// Handing a Device Solve() to a worker costs more than a small Solve() itself, so only the child Devices expected
+		// to do a lot of work are offloaded. The rest are solved inline on this thread while the workers get on with it.
+		m_offload_order.clear();
+		for (const auto& this_local_device_index : m_solve_order) {
+			Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
+			this_device_pointer->m_solve_inline_flag = (this_device_pointer->EstimateSolveWork() < m_top_level_sim_pointer->m_min_offload_work);
+			if (!this_device_pointer->m_solve_inline_flag) {
+				m_offload_order.push_back(this_local_device_index);
+			}
+		}
+		VoidThreadPool* thread_pool_pointer = m_top_level_sim_pointer->m_thread_pool_pointer;
+		VoidSpinBarrier* solve_barrier_pointer = m_top_level_sim_pointer->m_solve_barrier_pointer;
+		int worker_count = thread_pool_pointer->GetWorkerCount();
+		bool persistent_workers_flag = m_top_level_sim_pointer->m_persistent_workers_running;
+		bool use_partitions_flag = (persistent_workers_flag || m_top_level_sim_pointer->m_use_cost_model);
+		void_job_group solve_group;
+		if (m_offload_order.size() > 0) {
+			if (persistent_workers_flag) {
+				// Persistent workers - post this solve pass. See Simulation::StartPersistentWorkers().
+				m_top_level_sim_pointer->m_partitioned_solve_device_pointer = this;
+				solve_barrier_pointer->ArriveAndWait();
+			} else if (use_partitions_flag) {
+				// Partitions were balanced from measured Solve() costs, see ChooseParallelSubtrees(). One job per worker
+				// partition, this thread solves the last one.
+				for (int partition_index = 0; partition_index < worker_count; partition_index ++) {
+					thread_pool_pointer->AddJob(solve_group, std::bind(&Device::SolvePartition, this, partition_index));
+				}
+			} else {
+				// Split into contiguous batches. This thread helps solve them while it waits, so there is one batch per
+				// worker plus one for us. Each call waits only on it's own job group, so child Devices may in turn solve
+				// their own children in parallel.
+				int offload_count = m_offload_order.size();
+				int batch_count = std::min(worker_count + 1, offload_count);
+				int first_order_index = 0;
+				for (int batch_index = 0; batch_index < batch_count; batch_index ++) {
+					int last_order_index = ((batch_index + 1) * offload_count) / batch_count;
+					thread_pool_pointer->AddJob(solve_group, std::bind(&Device::SolveChildDeviceBatch, this, first_order_index, last_order_index));
+					first_order_index = last_order_index;
+				}
+			}
+		}
+		for (const auto& this_local_device_index : m_solve_order) {
+			Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
+			if (this_device_pointer->m_solve_inline_flag) {
+				this_device_pointer->SolveAsParallelChild();
+			}
+		}
+		if (m_offload_order.size() > 0) {
+			if (use_partitions_flag) {
+				SolvePartition(worker_count);
+			}
+			// Wait until all offloaded Device Solve()s finish.
+			if (persistent_workers_flag) {
+				solve_barrier_pointer->ArriveAndWait();
+			} else {
+				thread_pool_pointer->WaitForJobs(solve_group);
+			}
+		}
+	}
+	// Child Devices buffer their out pin changes during Solve(). Queue them for propagation here, in the order they
+	// were queued to Solve(), so the result does not depend on the order (or thread) they were solved in.
+	for (const auto& this_local_device_index : m_solve_this_tick) {
+		Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
+		if (this_device_pointer->m_buffered_propagation) {
+			this_device_pointer->m_buffered_propagation = false;
+			m_propagate_next_tick.emplace_back(this_local_device_index);
+		}
+		m_solve_work += this_device_pointer->m_solve_work;
+		// Likewise anything the child Devices logged (into the event buffer of whatever is being solved on this thread,
+		// if this Device is itself being solved in parallel).
+		if (m_solve_children_in_own_threads) {
+			solve_event_buffer& child_events = this_device_pointer->m_solve_events;
+			for (const auto& this_message : child_events.messages) {
+				m_top_level_sim_pointer->LogMessage(this_message);
+			}
+			for (const auto& this_error_message : child_events.error_messages) {
+				m_top_level_sim_pointer->LogError(this_error_message);
+			}
+			child_events.messages.clear();
+			child_events.error_messages.clear();
+		}
+	}
+}
+
+void Device::SolveAsParallelChild() {
+	// A Device solved in parallel with it's siblings only touches it's own subtree, apart from messages and errors.
+	// Those go into it's own event buffer for the parent to merge in queue order (see SolvePendingChildDevices()), so
+	// the log is the same whichever thread (and in whatever order) the siblings were solved.
+	solve_event_buffer* outer_event_buffer = Simulation::mg_solve_event_buffer;
+	Simulation::mg_solve_event_buffer = &m_solve_events;
+	Solve(true, 0);
+	Simulation::mg_solve_event_buffer = outer_event_buffer;
+}
+
+double Device::EstimateSolveWork() {
+	// In units of child Components propagated - the larger of what is queued right now and what a Solve() of this
+	// Device has recently cost.
+	return std::max(m_solve_work_estimate, double(m_changed_in_pins.size() + m_propagate_next_tick.size()));
+}
+
+void Device::SolveChildDeviceBatch(const int first_order_index, const int last_order_index) {
+	for (int order_index = first_order_index; order_index < last_order_index; order_index ++) {
+		Device* this_device_pointer = static_cast<Device*>(m_components[m_offload_order[order_index]].component_pointer);
+		this_device_pointer->SolveAsParallelChild();
+	}
+}
+
+void Device::SolvePartition(const int partition_index) {
+	for (const auto& this_local_device_index : m_solve_order) {
+		Device* this_device_pointer = static_cast<Device*>(m_components[this_local_device_index].component_pointer);
+		if ((this_device_pointer->m_solve_partition == partition_index) && !this_device_pointer->m_solve_inline_flag) {
+			this_device_pointer->SolveAsParallelChild();
+		}
+	}
+}
+
+void Device::AssignSolvePartitions(const int partition_count) {
+	if (m_solve_children_in_own_threads) {
+		// Contiguous runs of child Devices, so that neighbouring (and usually connected) Devices share a worker.
+		int device_count = m_devices.size();
+		for (int device_index = 0; device_index < device_count; device_index ++) {
+			Device* this_device_pointer = static_cast<Device*>(m_components[m_devices[device_index]].component_pointer);
+			this_device_pointer->m_solve_partition = (device_index * partition_count) / device_count;
+		}
+	} else if (m_nesting_level < m_top_level_sim_pointer->m_threaded_solve_nesting_level) {
+		for (const auto& this_local_device_index : m_devices) {
+			static_cast<Device*>(m_components[this_local_device_index].component_pointer)->AssignSolvePartitions(partition_count);
+		}
+	}
+}
+
+void Device::UpdateSolveCosts(const double smoothing) {
+	// Exponentially weighted moving average of the Solve() time accumulated over the last tick.
+	m_solve_cost += smoothing * (m_solve_cost_accumulator - m_solve_cost);
+	m_solve_cost_accumulator = 0.0;
+	for (const auto& this_local_device_index : m_devices) {
+		static_cast<Device*>(m_components[this_local_device_index].component_pointer)->UpdateSolveCosts(smoothing);
+	}
+}
+
+void Device::ChooseParallelSubtrees(const int partition_count, const bool allow_nesting, const double min_parallel_gain) {
+	// Solving the child Devices in parallel is worthwhile if enough of their work can overlap the largest of them (which
+	// bounds the parallel solve time). Otherwise look further down the tree. A child Device that would still be the
+	// bottleneck of a parallel solve can itself solve it's children in parallel, if nesting is allowed.
+	double total_child_cost = 0.0;
+	double largest_child_cost = 0.0;
+	std::vector<double> child_costs = {};
+	for (const auto& this_local_device_index : m_devices) {
+		double this_cost = static_cast<Device*>(m_components[this_local_device_index].component_pointer)->m_solve_cost;
+		child_costs.push_back(this_cost);
+		total_child_cost += this_cost;
+		largest_child_cost = std::max(largest_child_cost, this_cost);
+	}
+	m_solve_children_in_own_threads = ((m_devices.size() > 1) && ((total_child_cost - largest_child_cost) >= min_parallel_gain));
+	if (m_solve_children_in_own_threads) {
+		std::vector<int> child_partitions = PartitionByCost(child_costs, partition_count);
+		for (size_t i = 0; i < m_devices.size(); i ++) {
+			static_cast<Device*>(m_components[m_devices[i]].component_pointer)->m_solve_partition = child_partitions[i];
+		}
+		if (m_top_level_sim_pointer->m_verbose_flag) {
+			std::string message = "Device " + m_full_name + " solves it's " + std::to_string(m_devices.size()) + " child Devices in parallel (child cost = "
+				+ std::to_string(int(total_child_cost)) + " ns/tick, largest = " + std::to_string(int(largest_child_cost)) + " ns/tick)";
+			m_top_level_sim_pointer->LogMessage(message);
+		}
+	}
+	for (size_t i = 0; i < m_devices.size(); i ++) {
+		Device* this_device_pointer = static_cast<Device*>(m_components[m_devices[i]].component_pointer);
+		if (!m_solve_children_in_own_threads || (allow_nesting && ((child_costs[i] * partition_count) > total_child_cost))) {
+			this_device_pointer->ChooseParallelSubtrees(partition_count, allow_nesting, min_parallel_gain);
+		}
+	}
+}
+
+template <class logging_policy>
 void Device::SubTick(const int index) {
-	if (mg_verbose_flag) {
-		std::string message = std::string("\n" + std::to_string(m_message_branch_id) + ": " + "Iteration: ") + std::to_string(index);
-		m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+	if constexpr (logging_policy::enabled) {
+		if (m_top_level_sim_pointer->m_verbose_flag) {
+			std::string message = std::string("\n" + std::to_string(m_message_branch_id) + ": " + "Iteration: ") + std::to_string(index);
+			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+		}
 	}
 	// ------------------------------------------
-	for (const auto& this_entry : m_propagate_next_tick) {
-		m_propagate_this_tick.emplace_back(this_entry);
-		m_propagate_this_tick_flags[this_entry] = true;
-		m_propagate_next_tick_flags[this_entry] = false;
+	// Advancing the epoch moves everything queued for the next sub-tick into this sub-tick without touching it's stamp.
+	m_propagate_epoch ++;
+	// Renumber while m_propagate_epoch + 1 is still non-zero - once it wraps to 0 it would match every un-queued stamp.
+	if (m_propagate_epoch == (std::numeric_limits<unsigned int>::max() - 1)) {
+		RenumberPropagateStamps(3);
 	}
-	m_propagate_next_tick.clear();
+	m_propagate_this_tick.swap(m_propagate_next_tick);
+	m_solve_work += m_propagate_this_tick.size();
+	m_defer_gate_evaluation = (m_propagate_this_tick.size() >= m_min_gate_batch_size);
+	const unsigned int propagated_stamp = m_propagate_epoch - 1;
 	for (const auto& this_entry : m_propagate_this_tick) {
-		m_propagate_this_tick_flags[this_entry] = false;
-		m_components[this_entry].component_pointer->Propagate();
+		m_propagate_stamps[this_entry] = propagated_stamp;
+		Component* this_component_pointer = m_components[this_entry].component_pointer;
+		if (this_component_pointer->GetDeviceFlag()) {
+			Device* this_device_pointer = static_cast<Device*>(this_component_pointer);
+			this_device_pointer->PropagateChangedPins<logging_policy>(this_device_pointer->m_changed_out_pins, false);
+		} else {
+			static_cast<Gate*>(this_component_pointer)->PropagateOutput<logging_policy>();
+		}
 	}
 	m_propagate_this_tick.clear();
+	if (m_deferred_gates.size() > 0) {
+		EvaluateDeferredGates<logging_policy>();
+	}
+	m_defer_gate_evaluation = false;
 	// ------------------------------------------
 }
 
+bool Device::CheckForOscillation(const int index) {
+	// Called before each sub-tick from m_oscillation_check_threshold onwards. A fingerprint of the Device state (every
+	// child Component's pins plus the propagation queue) is compared against a saved fingerprint, which is moved on at
+	// power-of-two intervals (Brent's cycle detection), so that a cycle of any length is found in O(1) per sub-tick.
+	// The per-child hashes are updated incrementally, only for Components propagated last sub-tick (and their
+	// targets) and Components queued to propagate next. A period must be seen twice in a row before we report it.
+	if (index == m_oscillation_check_threshold) {
+		int component_count = m_components.size();
+		m_oscillation_child_hashes.assign(component_count, 0);
+		m_oscillation_hash = 0;
+		for (int i = 0; i < component_count; i ++) {
+			UpdateOscillationHash(i);
+		}
+		m_oscillation_power = 1;
+		m_oscillation_steps = 0;
+		m_oscillation_period = 0;
+		m_oscillation_components.clear();
+	} else {
+		for (const auto& this_local_index : m_oscillation_last_queue) {
+			UpdateOscillationHash(this_local_index);
+			Component* this_component_pointer = m_components[this_local_index].component_pointer;
+			std::vector<fanout_descriptor const*> onward_fanouts = {};
+			if (this_component_pointer->GetDeviceFlag()) {
+				Device* this_device_pointer = static_cast<Device*>(this_component_pointer);
+				for (const auto& this_pin : this_device_pointer->m_pins) {
+					if (this_pin.direction == 2) {
+						onward_fanouts.push_back(&this_device_pointer->m_port_fanouts[this_pin.port_index]);
+					}
+				}
+			} else {
+				onward_fanouts.push_back(&static_cast<Gate*>(this_component_pointer)->GetFanout());
+			}
+			for (const auto& this_fanout : onward_fanouts) {
+				for (const auto& this_target : this_fanout->gate_targets) {
+					UpdateOscillationHash(this_target.target_gate_pointer->GetLocalComponentIndex());
+				}
+				for (const auto& this_target : this_fanout->device_targets) {
+					if (this_target.target_device_pointer != this) {
+						UpdateOscillationHash(this_target.target_device_pointer->GetLocalComponentIndex());
+					}
+				}
+			}
+		}
+		for (const auto& this_local_index : m_propagate_next_tick) {
+			UpdateOscillationHash(this_local_index);
+		}
+	}
+	uint64_t fingerprint = m_oscillation_hash;
+	for (const auto& this_local_index : m_propagate_next_tick) {
+		fingerprint = MixHash(fingerprint ^ uint64_t(this_local_index));
+	}
+	m_oscillation_last_queue = m_propagate_next_tick;
+	if (index == m_oscillation_check_threshold) {
+		m_oscillation_fingerprint = fingerprint;
+		return false;
+	}
+	m_oscillation_steps ++;
+	if (fingerprint == m_oscillation_fingerprint) {
+		if (m_oscillation_steps == m_oscillation_period) {
+			return true;
+		}
+		// First sighting of this period - record the Components that propagate over the next period to confirm it.
+		m_oscillation_period = m_oscillation_steps;
+		m_oscillation_steps = 0;
+		m_oscillation_components.clear();
+	} else if (m_oscillation_steps == m_oscillation_power) {
+		m_oscillation_fingerprint = fingerprint;
+		m_oscillation_power *= 2;
+		m_oscillation_steps = 0;
+	}
+	if (m_oscillation_period > 0) {
+		m_oscillation_components.insert(m_oscillation_components.end(), m_propagate_next_tick.begin(), m_propagate_next_tick.end());
+	}
+	return false;
+}
+
+void Device::UpdateOscillationHash(const int local_component_index) {
+	uint64_t child_hash = MixHash(m_components[local_component_index].component_pointer->GetPinStateHash() ^ (uint64_t(local_component_index) << 32));
+	m_oscillation_hash ^= m_oscillation_child_hashes[local_component_index] ^ child_hash;
+	m_oscillation_child_hashes[local_component_index] = child_hash;
+}
+
+std::string Device::DescribeOscillation() {
+	// List the Components (and for Gates, the nets they drive) that propagated during the oscillation period.
+	std::sort(m_oscillation_components.begin(), m_oscillation_components.end());
+	m_oscillation_components.erase(std::unique(m_oscillation_components.begin(), m_oscillation_components.end()), m_oscillation_components.end());
+	const size_t max_listed = 16;
+	std::string description = " Looping nets:";
+	for (size_t i = 0; (i < m_oscillation_components.size()) && (i < max_listed); i ++) {
+		Component* this_component_pointer = m_components[m_oscillation_components[i]].component_pointer;
+		description += " " + this_component_pointer->GetFullName();
+		if (!this_component_pointer->GetDeviceFlag()) {
+			description += ":output";
+		}
+	}
+	if (m_oscillation_components.size() > max_listed) {
+		description += " (and " + std::to_string(m_oscillation_components.size() - max_listed) + " more)";
+	}
+	return description;
+}
+
+void Device::DerivePropagationBudget() {
+	// Finds the strongly connected components (Tarjan) of the child Component graph - edges run from each child to
+	// the children it drives - and the longest path through the resulting DAG, counting each feedback loop as the
+	// number of Components in it. Every sub-tick moves a change on by (at least) one Component, so without feedback
+	// a Solve() pass can not need more sub-ticks than the longest path, and can not oscillate.
+	//	- Acyclic Devices get exactly that budget (or the explicit one, if larger), and no oscillation checks.
+	//	- Devices with feedback get at least twice the longest path, and start looking for oscillation once the
+	//	  longest path has been covered, as any activity after that must be circulating around a loop.
+	int component_count = m_components.size();
+	std::vector<std::vector<int>> successors(component_count);
+	bool self_loop_flag = false;
+	for (int i = 0; i < component_count; i ++) {
+		Component* this_component_pointer = m_components[i].component_pointer;
+		std::vector<fanout_descriptor const*> onward_fanouts = {};
+		if (this_component_pointer->GetDeviceFlag()) {
+			Device* this_device_pointer = static_cast<Device*>(this_component_pointer);
+			for (const auto& this_pin : this_device_pointer->m_pins) {
+				if (this_pin.direction == 2) {
+					onward_fanouts.push_back(&this_device_pointer->m_port_fanouts[this_pin.port_index]);
+				}
+			}
+		} else {
+			onward_fanouts.push_back(&static_cast<Gate*>(this_component_pointer)->GetFanout());
+		}
+		for (const auto& this_fanout : onward_fanouts) {
+			for (const auto& this_target : this_fanout->gate_targets) {
+				successors[i].push_back(this_target.target_gate_pointer->GetLocalComponentIndex());
+			}
+			for (const auto& this_target : this_fanout->device_targets) {
+				if (this_target.target_device_pointer != this) {
+					successors[i].push_back(this_target.target_device_pointer->GetLocalComponentIndex());
+				}
+			}
+		}
+		for (const auto& this_successor : successors[i]) {
+			if (this_successor == i) {
+				self_loop_flag = true;
+			}
+		}
+	}
+	// Iterative Tarjan. SCCs are completed sinks-first, so the longest path from each can be found as it completes.
+	std::vector<int> visit_index(component_count, -1);
+	std::vector<int> low_link(component_count, 0);
+	std::vector<int> scc_of(component_count, -1);
+	std::vector<bool> on_stack(component_count, false);
+	std::vector<int> scc_stack = {};
+	std::vector<std::pair<int, size_t>> call_stack = {};
+	std::vector<int> scc_longest_path = {};
+	int next_visit_index = 0;
+	int longest_path = 0;
+	int feedback_loop_count = 0;
+	for (int root = 0; root < component_count; root ++) {
+		if (visit_index[root] >= 0) {
+			continue;
+		}
+		call_stack.push_back({root, 0});
+		visit_index[root] = low_link[root] = next_visit_index ++;
+		scc_stack.push_back(root);
+		on_stack[root] = true;
+		while (call_stack.size() > 0) {
+			int node = call_stack.back().first;
+			size_t& edge_index = call_stack.back().second;
+			if (edge_index < successors[node].size()) {
+				int successor = successors[node][edge_index];
+				edge_index ++;
+				if (visit_index[successor] < 0) {
+					visit_index[successor] = low_link[successor] = next_visit_index ++;
+					scc_stack.push_back(successor);
+					on_stack[successor] = true;
+					call_stack.push_back({successor, 0});
+				} else if (on_stack[successor]) {
+					low_link[node] = std::min(low_link[node], visit_index[successor]);
+				}
+				continue;
+			}
+			call_stack.pop_back();
+			if (call_stack.size() > 0) {
+				int caller = call_stack.back().first;
+				low_link[caller] = std::min(low_link[caller], low_link[node]);
+			}
+			if (low_link[node] == visit_index[node]) {
+				// Node is the root of a completed SCC.
+				int scc_index = scc_longest_path.size();
+				std::vector<int> members = {};
+				int member;
+				do {
+					member = scc_stack.back();
+					scc_stack.pop_back();
+					on_stack[member] = false;
+					scc_of[member] = scc_index;
+					members.push_back(member);
+				} while (member != node);
+				if (members.size() > 1) {
+					feedback_loop_count ++;
+				}
+				int downstream_path = 0;
+				for (const auto& this_member : members) {
+					for (const auto& this_successor : successors[this_member]) {
+						if (scc_of[this_successor] != scc_index) {
+							downstream_path = std::max(downstream_path, scc_longest_path[scc_of[this_successor]]);
+						}
+					}
+				}
+				scc_longest_path.push_back(downstream_path + (int)members.size());
+				longest_path = std::max(longest_path, scc_longest_path.back());
+			}
+		}
+	}
+	bool feedback_flag = ((feedback_loop_count > 0) || self_loop_flag);
+	if (!feedback_flag) {
+		if (m_explicit_max_propagations_flag) {
+			m_max_propagations = std::max(m_configured_max_propagations, longest_path);
+		} else {
+			m_max_propagations = std::max(longest_path, 1);
+		}
+		m_oscillation_check_threshold = std::numeric_limits<int>::max();
+	} else {
+		m_max_propagations = std::max(m_configured_max_propagations, 2 * longest_path);
+		m_oscillation_check_threshold = std::min(longest_path, m_max_propagations / 2);
+	}
+	if (m_top_level_sim_pointer->m_verbose_flag) {
+		std::string message = "Device " + m_full_name + " longest path = " + std::to_string(longest_path) + ", feedback loops = "
+			+ std::to_string(feedback_loop_count) + ", propagation budget = " + std::to_string(m_max_propagations);
+		m_top_level_sim_pointer->LogMessage(message);
+	}
+}
+
+void Device::RenumberPropagateStamps(const unsigned int new_propagate_epoch) {
+	// Restart the epoch count before it wraps around, keeping any queued Components queued. Stale stamps are reset
+	// so that they cannot match a future epoch.
+	for (auto& this_stamp : m_propagate_stamps) {
+		if (this_stamp == m_propagate_epoch) {
+			this_stamp = new_propagate_epoch;
+		} else if (this_stamp == m_propagate_epoch + 1) {
+			this_stamp = new_propagate_epoch + 1;
+		} else {
+			this_stamp = 0;
+		}
+	}
+	m_propagate_epoch = new_propagate_epoch;
+}
+
+void Device::SetPropagateEpoch(const unsigned int new_propagate_epoch) {
+	// Moves the epoch count (eg close to the point where it is renumbered, to exercise that). Stamps 0 to 2 and the
+	// last two values are reserved, see RenumberPropagateStamps().
+	if ((new_propagate_epoch < 3) || (new_propagate_epoch > (std::numeric_limits<unsigned int>::max() - 2))) {
+		std::string error_message = "Device " + m_full_name + " propagation epoch can not be set to " + std::to_string(new_propagate_epoch) + ".";
+		m_top_level_sim_pointer->LogError(error_message);
+		return;
+	}
+	RenumberPropagateStamps(new_propagate_epoch);
+}
+
+void Device::RelocateChildGates() {
+	// Gates are allocated one at a time as the Device is built, so Gates that are Set() one after the other can be
+	// scattered across the heap. Here we order the child Gates breadth-first along the fanout from this Device's in
+	// pins (passing through child Devices via their out pins), and then copy them - and with them their pin and
+	// connection storage - into a single block in that order. Local component indices are not changed.
+	int component_count = m_components.size();
+	std::vector<bool> visited(component_count, false);
+	std::vector<int> visit_queue = {};
+	std::vector<int> gate_order = {};
+	for (const auto& this_pin : m_pins) {
+		if ((this_pin.direction == 1) || (this_pin.direction == 3)) {
+			for (const auto& this_target : m_port_fanouts[this_pin.port_index].gate_targets) {
+				visit_queue.push_back(this_target.target_gate_pointer->GetLocalComponentIndex());
+			}
+			for (const auto& this_target : m_port_fanouts[this_pin.port_index].device_targets) {
+				if (this_target.target_device_pointer != this) {
+					visit_queue.push_back(this_target.target_device_pointer->GetLocalComponentIndex());
+				}
+			}
+		}
+	}
+	for (size_t queue_index = 0; queue_index < visit_queue.size(); queue_index ++) {
+		int this_local_index = visit_queue[queue_index];
+		if (visited[this_local_index]) {
+			continue;
+		}
+		visited[this_local_index] = true;
+		Component* this_component_pointer = m_components[this_local_index].component_pointer;
+		std::vector<fanout_descriptor const*> onward_fanouts = {};
+		if (this_component_pointer->GetDeviceFlag()) {
+			Device* this_device_pointer = static_cast<Device*>(this_component_pointer);
+			for (const auto& this_pin : this_device_pointer->m_pins) {
+				if (this_pin.direction == 2) {
+					onward_fanouts.push_back(&this_device_pointer->m_port_fanouts[this_pin.port_index]);
+				}
+			}
+		} else {
+			gate_order.push_back(this_local_index);
+			onward_fanouts.push_back(&static_cast<Gate*>(this_component_pointer)->GetFanout());
+		}
+		for (const auto& this_fanout : onward_fanouts) {
+			for (const auto& this_target : this_fanout->gate_targets) {
+				visit_queue.push_back(this_target.target_gate_pointer->GetLocalComponentIndex());
+			}
+			for (const auto& this_target : this_fanout->device_targets) {
+				if (this_target.target_device_pointer != this) {
+					visit_queue.push_back(this_target.target_device_pointer->GetLocalComponentIndex());
+				}
+			}
+		}
+	}
+	// Any Gates not reached from the in pins follow in build order.
+	for (int i = 0; i < component_count; i ++) {
+		if ((!visited[i]) && (!m_components[i].component_pointer->GetDeviceFlag())) {
+			gate_order.push_back(i);
+		}
+	}
+	if (gate_order.size() == 0) {
+		return;
+	}
+	// Copy all the Gates before deleting any of the originals, so that their pin and connection storage is allocated
+	// in order too.
+	char* gate_block = static_cast<char*>(::operator new(gate_order.size() * sizeof(Gate)));
+	m_gate_block = gate_block;
+	std::unordered_map<Component*, Component*> pointer_map;
+	std::vector<Gate*> original_gates = {};
+	for (size_t i = 0; i < gate_order.size(); i ++) {
+		Gate* original_gate_pointer = static_cast<Gate*>(m_components[gate_order[i]].component_pointer);
+		Gate* relocated_gate_pointer = original_gate_pointer->RelocateTo(gate_block + (i * sizeof(Gate)));
+		pointer_map[original_gate_pointer] = relocated_gate_pointer;
+		m_components[gate_order[i]].component_pointer = relocated_gate_pointer;
+		original_gates.push_back(original_gate_pointer);
+	}
+	for (const auto& this_original_gate_pointer : original_gates) {
+		delete this_original_gate_pointer;
+	}
+	// Finally, point everything that referred to the original Gates at the relocated ones. Only this Device's in pins,
+	// it's children, and (for top-level Gates) the Simulation's Clocks and Probes can refer to a child Gate.
+	RemapConnections(pointer_map);
+	for (const auto& this_component_descriptor : m_components) {
+		if (this_component_descriptor.component_pointer->GetDeviceFlag()) {
+			static_cast<Device*>(this_component_descriptor.component_pointer)->RemapConnections(pointer_map);
+		} else {
+			static_cast<Gate*>(this_component_descriptor.component_pointer)->RemapConnections(pointer_map);
+		}
+	}
+	m_top_level_sim_pointer->RemapComponentPointers(pointer_map);
+}
+
+void Device::RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map) {
+	for (size_t i = 0; i < m_ports.size(); i ++) {
+		for (auto& this_connection_descriptor : m_ports[i]) {
+			auto this_mapping = pointer_map.find(this_connection_descriptor.target_component_pointer);
+			if (this_mapping != pointer_map.end()) {
+				this_connection_descriptor.target_component_pointer = this_mapping->second;
+			}
+		}
+		BuildFanout(m_ports[i], m_port_fanouts[i]);
+	}
+}
+
+void Device::CloneChildComponents(std::unordered_map<Component*, Component*>& pointer_map) {
+	// Called on a fresh copy of a built Device (see Simulation::Clone()), whose child Component descriptors still
+	// point at the original's children. Relocated Gates are copied into a new Gate block at the same offsets.
+	char* original_gate_block = static_cast<char*>(m_gate_block);
+	int relocated_gate_count = 0;
+	for (const auto& this_component_descriptor : m_components) {
+		if (this_component_descriptor.component_pointer->GetRelocatedFlag()) {
+			relocated_gate_count ++;
+		}
+	}
+	m_gate_block = 0;
+	if (relocated_gate_count > 0) {
+		m_gate_block = ::operator new(relocated_gate_count * sizeof(Gate));
+	}
+	for (auto& this_component_descriptor : m_components) {
+		Component* original_component_pointer = this_component_descriptor.component_pointer;
+		Component* cloned_component_pointer = 0;
+		if (original_component_pointer->GetDeviceFlag()) {
+			Device* cloned_device_pointer = new ClonedDevice(*static_cast<Device*>(original_component_pointer), this);
+			cloned_device_pointer->CloneChildComponents(pointer_map);
+			cloned_component_pointer = cloned_device_pointer;
+		} else {
+			Gate* original_gate_pointer = static_cast<Gate*>(original_component_pointer);
+			void* destination = 0;
+			if (original_gate_pointer->GetRelocatedFlag()) {
+				destination = static_cast<char*>(m_gate_block) + (reinterpret_cast<char*>(original_gate_pointer) - original_gate_block);
+			}
+			cloned_component_pointer = original_gate_pointer->CloneInto(this, destination);
+		}
+		pointer_map[original_component_pointer] = cloned_component_pointer;
+		this_component_descriptor.component_pointer = cloned_component_pointer;
+	}
+	m_deferred_gates.clear();
+}
+
+void Device::RemapSubtreeConnections(std::unordered_map<Component*, Component*> const& pointer_map) {
+	// Point this Device's in pin connections, and those of every Component below it, at the mapped Components.
+	RemapConnections(pointer_map);
+	for (const auto& this_component_descriptor : m_components) {
+		if (this_component_descriptor.component_pointer->GetDeviceFlag()) {
+			static_cast<Device*>(this_component_descriptor.component_pointer)->RemapSubtreeConnections(pointer_map);
+		} else {
+			static_cast<Gate*>(this_component_descriptor.component_pointer)->RemapConnections(pointer_map);
+		}
+	}
+}
+
+ClonedDevice::ClonedDevice(Device const& original_device, Device* parent_device_pointer)
+ : Device(original_device) {
+	m_parent_device_pointer = parent_device_pointer;
+	m_top_level_sim_pointer = parent_device_pointer->GetTopLevelSimPointer();
+}
+
+void ClonedDevice::Build() {
+	// Nothing to build - a ClonedDevice is populated by copying, see Device::CloneChildComponents().
+}
+
+void Device::DeferGateEvaluation(Gate* gate_pointer) {
+	m_deferred_gates.push_back(gate_pointer);
+}
+
+template <class logging_policy>
+void Device::EvaluateDeferredGates() {
+	// Evaluate all Gates whose in pins changed since the last call, grouped by operator, then apply the new output
+	// states (queuing changed Gates to propagate) in the order the Gates were deferred.
+	int deferred_count = m_deferred_gates.size();
+	if (m_deferred_gates.size() < m_min_gate_batch_size) {
+		// Not worth batching, evaluate each Gate in turn.
+		for (const auto& this_gate_pointer : m_deferred_gates) {
+			this_gate_pointer->Evaluate<logging_policy>();
+		}
+		m_deferred_gates.clear();
+		return;
+	}
+	for (auto& this_batch : m_gate_batches) {
+		this_batch.in_pin_words.clear();
+		this_batch.in_pin_unknown_words.clear();
+		this_batch.in_pin_masks.clear();
+		this_batch.deferred_indices.clear();
+	}
+	for (int i = 0; i < deferred_count; i ++) {
+		m_deferred_gates[i]->AddToGateBatch(m_gate_batches, i);
+	}
+	m_deferred_results.resize(deferred_count);
+	for (int operator_index = 0; operator_index < GATE_OPERATOR_COUNT; operator_index ++) {
+		gate_batch& this_batch = m_gate_batches[operator_index];
+		if (this_batch.in_pin_words.size() > 0) {
+			Gate::EvaluateGateBatch(operator_index, this_batch);
+			for (size_t i = 0; i < this_batch.deferred_indices.size(); i ++) {
+				m_deferred_results[this_batch.deferred_indices[i]] = this_batch.results[i];
+			}
+		}
+	}
+	for (int i = 0; i < deferred_count; i ++) {
+		m_deferred_gates[i]->ApplyEvaluation<logging_policy>(m_deferred_results[i]);
+	}
+	m_deferred_gates.clear();
+}
+
 void Device::AppendChildPropagationIdentifier(const int propagation_identifier) {
-	if (!m_solve_children_in_own_threads) {
+	if (!m_solve_children_in_own_threads && !m_building_children_in_parallel) {
 		m_propagate_next_tick.emplace_back(propagation_identifier);
+		m_propagate_stamps[propagation_identifier] = m_propagate_epoch + 1;
 	} else {
-		std::unique_lock<std::mutex> lock(m_propagation_lock);
-		m_propagate_next_tick.emplace_back(propagation_identifier);
+		// Child Components of a threaded-solve (or parallel-building) Device may append from several threads. They go via a lock-free queue
+		// that the thread solving this Device drains at the start of Solve().
+		m_child_propagation_queue.Push(propagation_identifier);
 	}
 }
 
 void Device::QueueToSolve(const int local_component_identifier) {
+	// Only ever called from the thread solving this Device - child Device in pins are Set() by this Device's own
+	// propagation, and child out pin changes reach siblings via SolvePendingChildDevices() after any parallel join.
 	m_solve_this_tick.emplace_back(local_component_identifier);
 } 
 
 void Device::QueueToPropagate(const int propagation_identifier) {
-	if ((!m_propagate_this_tick_flags[propagation_identifier]) && (!m_propagate_next_tick_flags[propagation_identifier])) {
+	// Only queue if not already queued this sub-tick (and not yet propagated) or queued for the next sub-tick.
+	if ((m_propagate_stamps[propagation_identifier] - m_propagate_epoch) > 1) {
 		m_propagate_next_tick.emplace_back(propagation_identifier);
-		m_propagate_next_tick_flags[propagation_identifier] = true;
+		m_propagate_stamps[propagation_identifier] = m_propagate_epoch + 1;
 	}
 }
 
 void Device::PropagateInputs() {
-	for (auto& this_pin : m_pins) {
-		if ((this_pin.direction == 1) || (this_pin.direction == 3)) {
-			if (this_pin.state_changed) {
-				if (mg_verbose_flag) {
-					std::string message = std::string(KBLD) + KBLU + "->" + RST + " Device " + KBLD + m_full_name + RST + " propagating input " + this_pin.name + " = " + BoolToChar(this_pin.state);
-					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-				}
-				this_pin.state_changed = false;
-				for (const auto& this_connection_descriptor : m_ports[this_pin.port_index]) {
-					this_connection_descriptor.target_component_pointer->Set(this_connection_descriptor.target_pin_port_index, this_pin.state);
-				}
-			}
-		}
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		PropagateChangedPins<verbose_logging>(m_changed_in_pins, true);
+	} else {
+		PropagateChangedPins<quiet_logging>(m_changed_in_pins, true);
 	}
 }
 
 void Device::Propagate() {
-	for (auto& this_pin : m_pins) {
-		if (this_pin.direction == 2) {
-			if (this_pin.state_changed) {
-				if (mg_verbose_flag) {
-					std::string message = std::string(KBLD) + KYEL + "->" + RST + " Device " + KBLD + m_full_name + RST + " propagating output " + this_pin.name + " = " + BoolToChar(this_pin.state);
-					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-				}
-				this_pin.state_changed = false;
-				for (const auto& this_connection_descriptor : m_ports[this_pin.port_index]) {
-					this_connection_descriptor.target_component_pointer->Set(this_connection_descriptor.target_pin_port_index, this_pin.state);
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		PropagateChangedPins<verbose_logging>(m_changed_out_pins, false);
+	} else {
+		PropagateChangedPins<quiet_logging>(m_changed_out_pins, false);
+	}
+}
+
+template <class logging_policy>
+void Device::PropagateChangedPins(std::vector<int>& changed_pin_port_indices, const bool input_pins_flag) {
+	// Pins are propagated in port order (as if every pin had been checked in turn), irrespective of the order they
+	// changed in. input_pins_flag only chooses which message is logged.
+	if (changed_pin_port_indices.size() > 1) {
+		std::sort(changed_pin_port_indices.begin(), changed_pin_port_indices.end());
+	}
+	for (size_t i = 0; i < changed_pin_port_indices.size(); i ++) {
+		pin& this_pin = m_pins[changed_pin_port_indices[i]];
+		if constexpr (logging_policy::enabled) {
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message;
+				if (input_pins_flag) {
+					message = std::string(KBLD) + KBLU + "->" + RST + " Device " + KBLD + m_full_name + RST + " propagating input " + *this_pin.name + " = " + LogicToChar(this_pin.state, this_pin.unknown);
+				} else {
+					message = std::string(KBLD) + KYEL + "->" + RST + " Device " + KBLD + m_full_name + RST + " propagating output " + *this_pin.name + " = " + LogicToChar(this_pin.state, this_pin.unknown);
 				}
+				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+			}
+		}
+		this_pin.state_changed = false;
+		fanout_descriptor const& this_fanout = m_port_fanouts[this_pin.port_index];
+		for (const auto& this_target : this_fanout.gate_targets) {
+			this_target.target_gate_pointer->SetLogic<logging_policy>(this_target.target_pin_port_index, this_pin.state, this_pin.unknown);
+		}
+		if (!this_pin.unknown) {
+			BroadcastSet<logging_policy>(this_fanout.device_targets, this_pin.state);
+		} else {
+			for (const auto& this_target : this_fanout.device_targets) {
+				this_target.target_device_pointer->SetLogic<logging_policy>(this_target.target_pin_port_index, this_pin.state, true);
 			}
 		}
 	}
+	changed_pin_port_indices.clear();
 }
 
 void Device::Set(const int pin_port_index, const bool state_to_set) {
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		SetLogic<verbose_logging>(pin_port_index, state_to_set, false);
+	} else {
+		SetLogic<quiet_logging>(pin_port_index, state_to_set, false);
+	}
+}
+
+void Device::SetUnknown(const int pin_port_index, const bool high_impedance) {
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		SetLogic<verbose_logging>(pin_port_index, high_impedance, true);
+	} else {
+		SetLogic<quiet_logging>(pin_port_index, high_impedance, true);
+	}
+}
+
+template <class logging_policy>
+void Device::SetLogic(const int pin_port_index, const bool state_to_set, const bool unknown_to_set) {
 	pin* this_pin = &m_pins[pin_port_index];
 	if (this_pin->direction == 1) {
-		if (state_to_set != this_pin->state) {
-			if ((m_monitor_on) || (mg_verbose_flag)) {
-				std::string monitor_message = "";
-				if (mg_verbose_flag) {
-					std::string message = std::string(KBLD) + KGRN + "  ->" + RST + " Device " + KBLD + m_full_name + RST + " input terminal " + KBLD + this_pin->name + RST + " set from " + BoolToChar(this_pin->state) + " to " + BoolToChar(state_to_set);
-					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-					monitor_message = "~" + std::to_string(m_message_branch_id) + ": ";
+		if ((state_to_set != this_pin->state) || (unknown_to_set != this_pin->unknown)) {
+			if constexpr (logging_policy::enabled) {
+				if ((m_monitor_on) || (m_top_level_sim_pointer->m_verbose_flag)) {
+					std::string monitor_message = "";
+					if (m_top_level_sim_pointer->m_verbose_flag) {
+						std::string message = std::string(KBLD) + KGRN + "  ->" + RST + " Device " + KBLD + m_full_name + RST + " input terminal " + KBLD + *this_pin->name + RST + " set from " + LogicToChar(this_pin->state, this_pin->unknown) + " to " + LogicToChar(state_to_set, unknown_to_set);
+						m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+						monitor_message = "~" + std::to_string(m_message_branch_id) + ": ";
+					}
+					monitor_message += std::string(KBLD) + KRED + "  MONITOR: " + RST + "Component " + KBLD + m_full_name + ":" + *m_component_type + RST + " input terminal " + KBLD + *this_pin->name + RST + " set to " + LogicToChar(state_to_set, unknown_to_set);
+					//~m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+					m_top_level_sim_pointer->LogMessage(monitor_message);
 				}
-				monitor_message += std::string(KBLD) + KRED + "  MONITOR: " + RST + "Component " + KBLD + m_full_name + ":" + m_component_type + RST + " input terminal " + KBLD + this_pin->name + RST + " set to " + BoolToChar(state_to_set);
-				//~m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-				m_top_level_sim_pointer->LogMessage(monitor_message);
 			}
-			if (m_magic_device_flag == true) {
+			// Magic event traps only fire on known states.
+			if ((m_magic_device_flag == true) && (!unknown_to_set)) {
 				if (m_magic_pin_flag[pin_port_index]) {
 					m_magic_engine_pointer->CheckMagicEventTrap(pin_port_index, state_to_set);
 				}
 			}
 			this_pin->state = state_to_set;
-			this_pin->state_changed = true;
+			this_pin->unknown = unknown_to_set;
+			MarkPinChanged(*this_pin);
 			if (!m_solve_this_tick_flag) {
 				m_solve_this_tick_flag = true;
 				m_parent_device_pointer->QueueToSolve(m_local_component_index);
 			}
 		}
 	} else if (this_pin->direction == 2) {
-		if (state_to_set != this_pin->state) {
-			if ((m_monitor_on) || (mg_verbose_flag)) {
-				std::string monitor_message = "";
-				if (mg_verbose_flag) {
-					std::string message = std::string(KBLD) + KRED + "  ->" + RST + " Device " + KBLD + m_full_name + RST + " output terminal " + KBLD + this_pin->name + RST + " set from " + BoolToChar(this_pin->state) + " to " + BoolToChar(state_to_set);
-					m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
-					monitor_message = "~" + std::to_string(m_message_branch_id) + ": ";
+		if ((state_to_set != this_pin->state) || (unknown_to_set != this_pin->unknown)) {
+			if constexpr (logging_policy::enabled) {
+				if ((m_monitor_on) || (m_top_level_sim_pointer->m_verbose_flag)) {
+					std::string monitor_message = "";
+					if (m_top_level_sim_pointer->m_verbose_flag) {
+						std::string message = std::string(KBLD) + KRED + "  ->" + RST + " Device " + KBLD + m_full_name + RST + " output terminal " + KBLD + *this_pin->name + RST + " set from " + LogicToChar(this_pin->state, this_pin->unknown) + " to " + LogicToChar(state_to_set, unknown_to_set);
+						m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_message_branch_id) + ": " + message);
+						monitor_message = "~" + std::to_string(m_message_branch_id) + ": ";
+					}
+					monitor_message += std::string(KBLD) + KRED + "  MONITOR: " + RST + "Component " + KBLD + m_full_name + ":" + *m_component_type + RST + " output terminal " + KBLD + *this_pin->name + RST + " set to " + LogicToChar(state_to_set, unknown_to_set);
+					m_top_level_sim_pointer->LogMessage(monitor_message);
 				}
-				monitor_message += std::string(KBLD) + KRED + "  MONITOR: " + RST + "Component " + KBLD + m_full_name + ":" + m_component_type + RST + " output terminal " + KBLD + this_pin->name + RST + " set to " + BoolToChar(state_to_set);
-				m_top_level_sim_pointer->LogMessage(monitor_message);
 			}
 			this_pin->state = state_to_set;
-			this_pin->state_changed = true;
+			this_pin->unknown = unknown_to_set;
+			MarkPinChanged(*this_pin);
 			// Buffer output pin changes until end of Solve()...
 			m_buffered_propagation = true;
 		}
 	} else {
-		if (this_pin->name == "all_stop") {
-			if (state_to_set) {
+		if (*this_pin->name == "all_stop") {
+			if (state_to_set && !unknown_to_set) {
 				std::string message = " ---!--- Device " + m_full_name + " ALL_STOP was asserted ---!---";
 				m_top_level_sim_pointer->LogError(message);
 			}
@@ -775,10 +1765,45 @@ void Device::Set(const int pin_port_index, const bool state_to_set) {
 	}
 }
 
+template <class logging_policy>
+void Device::BroadcastSet(std::vector<device_connection_descriptor> const& targets, const bool state_to_set) {
+	// Sets the same known state on an in pin of many Devices at once, as for a Clock net or a Device in pin that
+	// fans out to many child Devices. Devices that are monitored, have magic event traps or are being logged verbosely
+	// take the normal Set() path. Otherwise the pin is updated in place, and the Device is only woken (queued to
+	// solve) if the pin drives something inside it - a Device that does not use the edge has nothing to solve.
+	for (const auto& this_target : targets) {
+		Device* target_device_pointer = this_target.target_device_pointer;
+		pin& target_pin = target_device_pointer->m_pins[this_target.target_pin_port_index];
+		if ((target_pin.state == state_to_set) && (!target_pin.unknown)) {
+			continue;
+		}
+		if ((logging_policy::enabled && (target_device_pointer->m_top_level_sim_pointer->m_verbose_flag || target_device_pointer->m_monitor_on)) || target_device_pointer->m_magic_device_flag || (target_pin.direction != 1)) {
+			target_device_pointer->SetLogic<logging_policy>(this_target.target_pin_port_index, state_to_set, false);
+		} else {
+			target_pin.state = state_to_set;
+			target_pin.unknown = false;
+			fanout_descriptor const& internal_fanout = target_device_pointer->m_port_fanouts[this_target.target_pin_port_index];
+			if ((internal_fanout.gate_targets.size() > 0) || (internal_fanout.device_targets.size() > 0)) {
+				target_device_pointer->MarkPinChanged(target_pin);
+				if (!target_device_pointer->m_solve_this_tick_flag) {
+					target_device_pointer->m_solve_this_tick_flag = true;
+					target_device_pointer->m_parent_device_pointer->QueueToSolve(target_device_pointer->m_local_component_index);
+				}
+			}
+		}
+	}
+}
+
+// The solver (see SolveWithPolicy()) is built for both logging policies.
+template void Device::SetLogic<quiet_logging>(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+template void Device::SetLogic<verbose_logging>(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+template void Device::BroadcastSet<quiet_logging>(std::vector<device_connection_descriptor> const& targets, const bool state_to_set);
+template void Device::BroadcastSet<verbose_logging>(std::vector<device_connection_descriptor> const& targets, const bool state_to_set);
+
 Component* Device::GetChildComponentPointer(std::string const& target_child_component_name) {
 	Component* child_component_pointer = 0;
 	for (const auto& this_component_descriptor : m_components) {
-		if (this_component_descriptor.component_name == target_child_component_name) {
+		if (*this_component_descriptor.component_name == target_child_component_name) {
 			child_component_pointer = this_component_descriptor.component_pointer;
 			break;
 		}
@@ -786,6 +1811,62 @@ Component* Device::GetChildComponentPointer(std::string const& target_child_comp
 	return child_component_pointer;
 }
 
+Component* Device::GetChildComponentPointer(const int local_component_index) {
+	return m_components[local_component_index].component_pointer;
+}
+
+int Device::CountSubtreeComponents() {
+	int component_count = m_components.size();
+	for (const auto& this_local_device_index : m_devices) {
+		component_count += static_cast<Device*>(m_components[this_local_device_index].component_pointer)->CountSubtreeComponents();
+	}
+	return component_count;
+}
+
+void Device::CollectChangedInPins(std::vector<boundary_pin_message>& boundary_pin_messages, const int tick_index) {
+	// Hand over this Device's pending in pin changes instead of Solve()ing it, as another process owns it (see
+	// Simulation::RunPartitioned()). The Device is then as if it had been Solve()d, so it can be queued again.
+	for (const auto& this_pin_port_index : m_changed_in_pins) {
+		pin& this_pin = m_pins[this_pin_port_index];
+		boundary_pin_messages.push_back({tick_index, m_local_component_index, this_pin_port_index, this_pin.state, this_pin.unknown});
+		this_pin.state_changed = false;
+	}
+	m_changed_in_pins.clear();
+	m_solve_this_tick_flag = false;
+}
+
+void Device::SaveState(std::vector<unsigned char>& state_buffer, const bool include_children) {
+	// Logic values of this Device's pins and, if include_children is set, of every Component below it. Only complete
+	// between Solve()s, when nothing is queued and no pin is flagged as changed, see Simulation::SavePartitionState().
+	SavePinStates(state_buffer);
+	if (include_children) {
+		for (const auto& this_component_descriptor : m_components) {
+			if (this_component_descriptor.component_pointer->GetDeviceFlag()) {
+				static_cast<Device*>(this_component_descriptor.component_pointer)->SaveState(state_buffer, true);
+			} else {
+				this_component_descriptor.component_pointer->SavePinStates(state_buffer);
+			}
+		}
+	}
+}
+
+unsigned char const* Device::RestoreState(unsigned char const* state_pointer, const bool include_children) {
+	state_pointer = RestorePinStates(state_pointer);
+	m_changed_in_pins.clear();
+	m_changed_out_pins.clear();
+	m_solve_this_tick_flag = false;
+	if (include_children) {
+		for (const auto& this_component_descriptor : m_components) {
+			if (this_component_descriptor.component_pointer->GetDeviceFlag()) {
+				state_pointer = static_cast<Device*>(this_component_descriptor.component_pointer)->RestoreState(state_pointer, true);
+			} else {
+				state_pointer = static_cast<Gate*>(this_component_descriptor.component_pointer)->RestoreState(state_pointer);
+			}
+		}
+	}
+	return state_pointer;
+}
+
 int Device::GetNestingLevel() {
 	return m_nesting_level;
 }
@@ -795,6 +1876,13 @@ int Device::GetMessageBranchID() {
 }
 
 int Device::GetNewLocalComponentIndex() {
+	// The first Component built with this Device as it's parent on an elaboration slot takes the index reserved for
+	// it (it's own children have a different parent, so are numbered as usual), see AddComponentsInParallel().
+	elaboration_slot* slot_pointer = Simulation::mg_elaboration_slot;
+	if ((slot_pointer != nullptr) && (slot_pointer->parent_device_pointer == this)) {
+		slot_pointer->parent_device_pointer = nullptr;
+		return slot_pointer->local_component_index;
+	}
 	int current_component_count = m_components.size();
 	return current_component_count;
 }
@@ -821,14 +1909,14 @@ void Device::PrintPinStates(int max_levels) {
 		for (const auto& pin_name : GetSortedInPinNames()) {
 			int pin_port_index = GetPinPortIndex(pin_name);
 			if (m_pins[pin_port_index].direction == 1) {
-				std::cout << " " << BoolToChar(m_pins[pin_port_index].state) << " ";
+				std::cout << " " << LogicToChar(m_pins[pin_port_index].state, m_pins[pin_port_index].unknown) << " ";
 			}
 		}
 		std::cout << "] [";
 		for (const auto& pin_name : GetSortedOutPinNames()) {
 			int pin_port_index = GetPinPortIndex(pin_name);
 			if (m_pins[pin_port_index].direction == 2) {
-				std::cout << " " << BoolToChar(m_pins[pin_port_index].state) << " ";
+				std::cout << " " << LogicToChar(m_pins[pin_port_index].state, m_pins[pin_port_index].unknown) << " ";
 			}
 		}
 		std::cout << "]" << std::endl;
@@ -846,8 +1934,41 @@ void Device::PrintInternalPinStates(int max_levels) {
 	}
 }
 
+int Device::ReportUnknownPins(const bool name_each_pin) {
+	// Count (recursively) the child Component out pins that are still X or Z, naming only the out pins of the top-level
+	// Devices unless name_each_pin is set. Only meaningful when the Simulation is using unknown states, and not an error -
+	// an X that is never used (or is cleared by a reset) is harmless.
+	int unknown_pin_count = 0;
+	bool name_pins_flag = (name_each_pin || (this == m_top_level_sim_pointer));
+	for (const auto& this_component_descriptor : m_components) {
+		Component* component_pointer = this_component_descriptor.component_pointer;
+		for (const auto& pin_name : component_pointer->GetSortedOutPinNames()) {
+			int pin_port_index = component_pointer->GetPinPortIndex(pin_name);
+			if (component_pointer->GetPinUnknown(pin_port_index)) {
+				unknown_pin_count ++;
+				if (name_pins_flag) {
+					std::string message = "Component " + component_pointer->GetFullName() + " out pin " + pin_name + " is "
+						+ LogicToChar(component_pointer->GetPinState(pin_port_index), true) + " after stabilising.";
+					m_top_level_sim_pointer->LogMessage(message);
+				}
+			}
+		}
+	}
+	for (const auto& this_device_local_id : m_devices) {
+		unknown_pin_count += static_cast<Device*>(m_components[this_device_local_id].component_pointer)->ReportUnknownPins(name_each_pin);
+	}
+	if ((this == m_top_level_sim_pointer) && (unknown_pin_count > 0)) {
+		std::string message = std::to_string(unknown_pin_count) + " Component out pins are X or Z after stabilising";
+		if (!name_each_pin) {
+			message += " (verbose output lists them all)";
+		}
+		m_top_level_sim_pointer->LogMessage(message + ".");
+	}
+	return unknown_pin_count;
+}
+
 void Device::ReportUnConnectedPins() {
-	if (mg_verbose_flag) {
+	if (m_top_level_sim_pointer->m_verbose_flag) {
 		std::string message = "Checking pins for Device " + m_full_name + " local component id = " + std::to_string(m_local_component_index);
 		m_top_level_sim_pointer->LogMessage(message);
 	}
@@ -856,24 +1977,24 @@ void Device::ReportUnConnectedPins() {
 			// We don't halt on a build error for un-driven input pins of upper-most level Devices.
 			if ((!this_pin.drive[0]) && (m_nesting_level > 1)) {
 				// Log undriven Device in pin.
-				std::string build_error = "Device " + m_full_name + " in pin " + this_pin.name + " is not driven by any Component.";
+				std::string build_error = "Device " + m_full_name + " in pin " + *this_pin.name + " is not driven by any Component.";
 				m_top_level_sim_pointer->LogError(build_error);
 			}
 			if (!this_pin.drive[1]) {
 				// Log undriving Device in pin.
-				std::string build_error = "Device " + m_full_name + " in pin " + this_pin.name + " drives no internal Components.";
+				std::string build_error = "Device " + m_full_name + " in pin " + *this_pin.name + " drives no internal Components.";
 				m_top_level_sim_pointer->LogError(build_error);
 			}
 		} else if (this_pin.direction == 2) {
 			if (!this_pin.drive[0]) {
 				// Log undriven Device out pin.
-				std::string build_error = "Device " + m_full_name + " out pin " + this_pin.name + " is not driven by any child Component.";
+				std::string build_error = "Device " + m_full_name + " out pin " + *this_pin.name + " is not driven by any child Component.";
 				m_top_level_sim_pointer->LogError(build_error);
 			}
 			// We don't halt on a build error for un-driving output pins of upper-most level Devices.
 			if ((!this_pin.drive[1]) && (m_nesting_level > 1)) {
 				// Log undriving Device out pin.
-				std::string build_error = "Device " + m_full_name + " out pin " + this_pin.name + " drives no Component.";
+				std::string build_error = "Device " + m_full_name + " out pin " + *this_pin.name + " drives no Component.";
 				m_top_level_sim_pointer->LogError(build_error);
 			}
 		}
@@ -909,10 +2030,10 @@ Component* Device::SearchForComponentPointer(std::string const& target_component
 		}
 		// Search the children of this level Device.
 		for (const auto& this_component_descriptor : m_components) {
-			if (this_component_descriptor.component_full_name == target_component_full_name) {
+			if (this_component_descriptor.component_pointer->GetFullName() == target_component_full_name) {
 				// Target Component is a child of this Device. Break and return it's pointer.
 				target_component_pointer = this_component_descriptor.component_pointer;
-				if (mg_verbose_flag) {
+				if (m_top_level_sim_pointer->m_verbose_flag) {
 					std::cout << "Component " << target_component_full_name << " found @ " << target_component_pointer << std::endl;
 				}
 				break;
@@ -945,7 +2066,7 @@ bool Device::GetDeletionFlag(void) {
 
 void Device::PurgeComponent() {
 	std::string header;
-	if (mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "Purging -> DEVICE :" + m_full_name + " @ " + PointerToString(static_cast<void*>(this));
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -981,7 +2102,7 @@ void Device::PurgeComponent() {
 		//			it's parent, we do not need to do this.
 		m_parent_device_pointer->PurgeChildComponentIdentifiers(this);
 	}
-	if (mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "DEVICE : " + m_full_name + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged.";
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -994,14 +2115,13 @@ void Device::PurgeAllChildComponents() {
 	for (const auto& this_component_descriptor : m_components) {
 		component_descriptor new_component_descriptor;
 		new_component_descriptor.component_name = this_component_descriptor.component_name;
-		new_component_descriptor.component_full_name = this_component_descriptor.component_full_name;
 		new_component_descriptor.component_pointer = this_component_descriptor.component_pointer;
 		m_components_copy.push_back(new_component_descriptor);
 	}
 	
 	// Now we can iterate over m_components_copy and blast away at m_components.
 	for (const auto& copied_component_descriptor : m_components_copy) {
-		delete copied_component_descriptor.component_pointer;
+		DeleteComponent(copied_component_descriptor.component_pointer);
 	}
 }
 
@@ -1036,7 +2156,7 @@ void Device::PurgeOutboundConnections() {
 				} else if ((target_pin_direction == 2) || (target_pin_direction == 4)) {		// We will clear hidden out pin drive in flags for completeness.
 					target_direction = "out";
 				}
-				if (mg_verbose_destructor_flag) {
+				if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 					std::cout << "Component " << target_component_pointer->GetFullName() << " " << target_direction << " pin "
 						<< target_component_pointer->GetPinName(this_connection_descriptor.target_pin_port_index) << " drive in set to false." << std::endl;
 				}
@@ -1071,7 +2191,7 @@ void Device::PurgeInboundConnections(Component* target_component_pointer) {
 			} else {
 				// This connection descriptor is to be omitted as it contains a reference to the target Component.
 				connections_removed ++;
-				if (mg_verbose_destructor_flag) {
+				if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 					std::cout << "Device " << m_full_name << " removed an " << direction << " connection from " << GetPinName(port_index) << " to "
 						<< this_connection_descriptor.target_component_pointer->GetFullName() << " in pin "
 						<< this_connection_descriptor.target_component_pointer->GetPinName(this_connection_descriptor.target_pin_port_index) << std::endl;
@@ -1081,7 +2201,7 @@ void Device::PurgeInboundConnections(Component* target_component_pointer) {
 		new_ports.push_back(this_new_port);
 		// If this port has had connection descriptors removed, and is now empty, set it's pin's drive out flag to false.
 		if ((this_new_port.size() == 0) && (connections_removed > 0)) {
-			if (mg_verbose_destructor_flag) {
+			if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 				std::cout << "Device " << m_full_name << " " << direction << " pin " << GetPinName(port_index) << " drive out set to false."  << std::endl;
 			}
 			SetPinDrivenFlag(port_index, 1, false);
@@ -1089,18 +2209,21 @@ void Device::PurgeInboundConnections(Component* target_component_pointer) {
 		port_index ++;
 	}
 	m_ports = new_ports;
+	for (size_t i = 0; i < m_ports.size(); i ++) {
+		BuildFanout(m_ports[i], m_port_fanouts[i]);
+	}
 }
 
 void Device::PurgeChildComponent(std::string const& target_component_name) {
 	Component* target_component_pointer = 0;
 	for (const auto& this_component_descriptor : m_components) {
-		if (this_component_descriptor.component_name == target_component_name) {
+		if (*this_component_descriptor.component_name == target_component_name) {
 			target_component_pointer = this_component_descriptor.component_pointer;
 			break;
 		}
 	}
 	if (target_component_pointer != 0) {
-		delete target_component_pointer;
+		DeleteComponent(target_component_pointer);
 	} else {
 		std::cout << "Child Component " << target_component_name << " not found." << std::endl;
 	}
@@ -1115,15 +2238,14 @@ void Device::PurgeChildComponentIdentifiers(Component* target_component_pointer)
 			if (i != current_local_component_index) {
 				new_m_devices.push_back(m_devices[i]);
 			} else {
-				if (mg_verbose_destructor_flag) {
+				if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 					std::cout << "Omitting local component id " << i << " " << target_component_pointer->GetFullName() << " from m_devices for parent Device " << m_full_name << std::endl;
 				}
 			}
 		}
 		m_devices = new_m_devices;
-		// Parent removes an entry from each of it's propagation flag vectors.
-		m_propagate_this_tick_flags.pop_back();
-		m_propagate_next_tick_flags.pop_back();
+		// Parent removes an entry from it's propagation stamp vector.
+		m_propagate_stamps.pop_back();
 	}
 	// Create a new m_components vector, omitting the Component to purge. 
 	size_t index = 0;
@@ -1133,7 +2255,6 @@ void Device::PurgeChildComponentIdentifiers(Component* target_component_pointer)
 		if (this_component_descriptor.component_pointer != target_component_pointer) {
 			component_descriptor new_component_descriptor;
 			new_component_descriptor.component_name = this_component_descriptor.component_name;
-			new_component_descriptor.component_full_name = this_component_descriptor.component_full_name;
 			new_component_descriptor.component_pointer = this_component_descriptor.component_pointer;
 			new_m_components.push_back(new_component_descriptor);
 		} else {
@@ -23,7 +23,8 @@
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::vector
 #include <algorithm>				// std::sort
-#include <cstdlib>					// rand()
+#include <new>						// placement new
+#include <unordered_map>			// std::unordered_map
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
@@ -33,48 +34,121 @@
 Gate::Gate(Device* parent_device_pointer, std::string const& gate_name, std::string const& gate_type,
 	std::vector<std::string> in_pin_names, bool monitor_on) {
 	m_device_flag = false;
-	m_name = gate_name;
+	m_name = GetSharedName(gate_name);
 	m_parent_device_pointer = parent_device_pointer;
 	m_top_level_sim_pointer = m_parent_device_pointer->GetTopLevelSimPointer();
 	m_CUID = m_top_level_sim_pointer->GetNewCUID();
 	m_local_component_index = m_parent_device_pointer->GetNewLocalComponentIndex();
 	m_nesting_level = m_parent_device_pointer->GetNestingLevel() + 1;
-	m_full_name = m_parent_device_pointer->GetFullName() + ":" + m_name;
-	m_parent_device_pointer->CreateChildFlags();
-	m_component_type = gate_type;
-	m_operator_function_pointer = GetOperatorPointer(m_component_type);
+	m_full_name = m_parent_device_pointer->GetFullName() + ":" + *m_name;
+	m_parent_device_pointer->CreateChildFlags(m_local_component_index);
+	m_component_type = GetSharedName(gate_type);
+	m_operator_index = GetOperatorIndex(*m_component_type);
 	m_monitor_on = monitor_on;
+	if (m_monitor_on) {
+		m_top_level_sim_pointer->m_monitored_component_count ++;
+	}
 	// If a not gate is being instantiated, cap the inputs list to the first input.
-	if (m_component_type == "not") {
+	if (*m_component_type == "not") {
 		in_pin_names = {"input"};
 	} else {
 		int number_of_in_pins = in_pin_names.size();
 		if (number_of_in_pins < 2) {
 			// Log build error here.		-- Not enough pins defined for this Gate!
-			std::string build_error = "Gate " + m_full_name + "(" + m_component_type + ") added with only " + std::to_string(number_of_in_pins) + " in pins specified.";
+			std::string build_error = "Gate " + m_full_name + "(" + *m_component_type + ") added with only " + std::to_string(number_of_in_pins) + " in pins specified.";
 			m_top_level_sim_pointer->LogError(build_error);
 		}
 	}
 	std::sort(in_pin_names.begin(), in_pin_names.end(), compareNat);
+	bool use_unknown_states = m_top_level_sim_pointer->m_use_unknown_states;
 	int new_pin_port_index = 0;
 	for (const auto& pin_name : in_pin_names) {
-		// Assign random states to Gate inputs.
-		bool temp_bool = rand() > (RAND_MAX / 2);
-		pin new_in_pin = {pin_name, 1, temp_bool, false, new_pin_port_index, {false, false}};
+		// Assign random states to Gate inputs (or X if the Simulation is using unknown states).
+		bool temp_bool = false;
+		if (!use_unknown_states) {
+			temp_bool = m_top_level_sim_pointer->GetRandomBool();
+		}
+		pin new_in_pin = {GetSharedName(pin_name), 1, temp_bool, false, new_pin_port_index, {false, false}, use_unknown_states};
 		m_pins.push_back(new_in_pin);
 		new_pin_port_index ++;
 	}
+	// In pins take the lowest port indices, so in pin n is bit n of the packed in pin words.
+	m_packed_flag = (new_pin_port_index <= 64);
+	if (m_packed_flag) {
+		for (int i = 0; i < new_pin_port_index; i ++) {
+			m_in_pin_mask |= (uint64_t(1) << i);
+			m_in_pin_word |= (uint64_t(m_pins[i].state) << i);
+			m_in_pin_unknown_word |= (uint64_t(m_pins[i].unknown) << i);
+		}
+	}
 	std::string out_pin_name = "output";
 	m_out_pin_port_index = new_pin_port_index;
-	pin new_out_pin = {out_pin_name, 2, false, false, new_pin_port_index, {false, false}};
+	pin new_out_pin = {GetSharedName(out_pin_name), 2, false, false, new_pin_port_index, {false, false}, use_unknown_states};
 	m_pins.push_back(new_out_pin);
 }
 
 Gate::~Gate() {
-	PurgeComponent();
-	if (mg_verbose_destructor_flag) {
-		std::cout << "Gate dtor for " << m_full_name << " @ " << this << std::endl;
+	// A Gate that has been relocated away no longer owns it's connections (the copy does), so there is nothing to purge.
+	if (!m_moved_from_flag) {
+		if (m_monitor_on) {
+			m_top_level_sim_pointer->m_monitored_component_count --;
+		}
+		PurgeComponent();
+		if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
+			std::cout << "Gate dtor for " << m_full_name << " @ " << this << std::endl;
+		}
+	}
+}
+
+Gate* Gate::RelocateTo(void* destination) {
+	// Copy this Gate (along with it's pin and connection storage) into the destination memory. Pointers held elsewhere
+	// to this Gate must then be remapped to the copy before this Gate is deleted.
+	Gate* relocated_gate_pointer = new (destination) Gate(*this);
+	relocated_gate_pointer->m_relocated_flag = true;
+	m_moved_from_flag = true;
+	return relocated_gate_pointer;
+}
+
+Gate* Gate::CloneInto(Device* parent_device_pointer, void* destination) {
+	// Copy this Gate into a cloned parent Device, in place if the destination is in the clone's Gate block. Connections
+	// still point at the original Simulation's Components until remapped, see Simulation::Clone().
+	Gate* cloned_gate_pointer = 0;
+	if (destination != 0) {
+		cloned_gate_pointer = new (destination) Gate(*this);
+	} else {
+		cloned_gate_pointer = new Gate(*this);
 	}
+	cloned_gate_pointer->m_parent_device_pointer = parent_device_pointer;
+	cloned_gate_pointer->m_top_level_sim_pointer = parent_device_pointer->GetTopLevelSimPointer();
+	return cloned_gate_pointer;
+}
+
+void Gate::RemapConnections(std::unordered_map<Component*, Component*> const& pointer_map) {
+	for (auto& this_connection_descriptor : m_connections) {
+		auto this_mapping = pointer_map.find(this_connection_descriptor.target_component_pointer);
+		if (this_mapping != pointer_map.end()) {
+			this_connection_descriptor.target_component_pointer = this_mapping->second;
+		}
+	}
+	BuildFanout(m_connections, m_fanout);
+}
+
+unsigned char const* Gate::RestoreState(unsigned char const* state_pointer) {
+	// As Component::RestorePinStates(), keeping the packed in pin words in step.
+	state_pointer = RestorePinStates(state_pointer);
+	if (m_packed_flag) {
+		m_in_pin_word = 0;
+		m_in_pin_unknown_word = 0;
+		for (int i = 0; i < m_out_pin_port_index; i ++) {
+			m_in_pin_word |= (uint64_t(m_pins[i].state) << i);
+			m_in_pin_unknown_word |= (uint64_t(m_pins[i].unknown) << i);
+		}
+	}
+	return state_pointer;
+}
+
+fanout_descriptor const& Gate::GetFanout() {
+	return m_fanout;
 }
 
 void Gate::Reset() {
@@ -83,13 +157,24 @@ void Gate::Reset() {
 		m_top_level_sim_pointer->SetSearchingFlag(true);
 		m_top_level_sim_pointer->Reset();
 	} else {
+		bool use_unknown_states = m_top_level_sim_pointer->m_use_unknown_states;
+		m_in_pin_word = 0;
+		m_in_pin_unknown_word = 0;
 		for (auto& this_pin : m_pins) {
 			if (this_pin.direction == 1) {
-				bool temp_bool = rand() > (RAND_MAX / 2);
+				bool temp_bool = false;
+				if (!use_unknown_states) {
+					temp_bool = m_top_level_sim_pointer->GetRandomBool();
+				}
 				this_pin.state = temp_bool;
+				if (m_packed_flag) {
+					m_in_pin_word |= (uint64_t(temp_bool) << this_pin.port_index);
+					m_in_pin_unknown_word |= (uint64_t(use_unknown_states) << this_pin.port_index);
+				}
 			} else {
 				this_pin.state = false;
 			}
+			this_pin.unknown = use_unknown_states;
 			this_pin.state_changed = false;
 		}
 	}
@@ -102,8 +187,9 @@ void Gate::Initialise() {
 	// To ensure that this does not take place, having set the input states of any gate connected to it's inputs, the parent device
 	// calls Initialise() for each remaining child gate to ensure it's output state is sensible with respect to it's initial input 
 	// states and that if it's output state has changed this change will be propagated during the subsequent Solve() call.
-	bool new_state = (this->*m_operator_function_pointer)(m_pins);
-	m_pins[m_out_pin_port_index].state = new_state;
+	unsigned char new_logic = ComputeOutput();
+	m_pins[m_out_pin_port_index].state = (new_logic & 1);
+	m_pins[m_out_pin_port_index].unknown = ((new_logic & 2) != 0);
 	m_pins[m_out_pin_port_index].state_changed = true;
 	m_parent_device_pointer->AppendChildPropagationIdentifier(m_local_component_index);
 }
@@ -144,6 +230,7 @@ void Gate::Connect(std::vector<std::string> connection_parameters) {
 					std::vector<bool> target_pin_already_driven = target_component_pointer->CheckIfPinDriven(new_connection_descriptor.target_pin_port_index);
 					if (!target_pin_already_driven[0]) {
 						m_connections.push_back(new_connection_descriptor);
+						BuildFanout(m_connections, m_fanout);
 						target_component_pointer->SetPinDrivenFlag(new_connection_descriptor.target_pin_port_index, false, true);
 						m_pins[m_out_pin_port_index].drive[1] = true;
 					} else {
@@ -174,139 +261,285 @@ void Gate::Connect(std::vector<std::string> connection_parameters) {
 }
 
 void Gate::Set(const int pin_port_index, const bool state_to_set) {
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		SetLogic<verbose_logging>(pin_port_index, state_to_set, false);
+	} else {
+		SetLogic<quiet_logging>(pin_port_index, state_to_set, false);
+	}
+}
+
+void Gate::SetUnknown(const int pin_port_index, const bool high_impedance) {
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		SetLogic<verbose_logging>(pin_port_index, high_impedance, true);
+	} else {
+		SetLogic<quiet_logging>(pin_port_index, high_impedance, true);
+	}
+}
+
+template <class logging_policy>
+void Gate::SetLogic(const int pin_port_index, const bool state_to_set, const bool unknown_to_set) {
 	pin* this_pin = &m_pins[pin_port_index];
-	if (this_pin->state != state_to_set) {
-		if (mg_verbose_flag) {
-			std::string message = std::string(KBLD) + KGRN + "  ->" + RST + " Gate " + KBLD + m_full_name + RST + " terminal " + KBLD + this_pin->name + RST + " set from " + BoolToChar(this_pin->state) + " to " + BoolToChar(state_to_set);
-			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
+	if ((this_pin->state != state_to_set) || (this_pin->unknown != unknown_to_set)) {
+		if constexpr (logging_policy::enabled) {
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = std::string(KBLD) + KGRN + "  ->" + RST + " Gate " + KBLD + m_full_name + RST + " terminal " + KBLD + *this_pin->name + RST + " set from " + LogicToChar(this_pin->state, this_pin->unknown) + " to " + LogicToChar(state_to_set, unknown_to_set);
+				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
+			}
 		}
 		this_pin->state = state_to_set;
-		Evaluate();
+		this_pin->unknown = unknown_to_set;
+		if (!m_packed_flag) {
+			Evaluate<logging_policy>();
+		} else {
+			uint64_t pin_bit = (uint64_t(1) << pin_port_index);
+			m_in_pin_word = (m_in_pin_word & ~pin_bit) | (uint64_t(state_to_set) << pin_port_index);
+			m_in_pin_unknown_word = (m_in_pin_unknown_word & ~pin_bit) | (uint64_t(unknown_to_set) << pin_port_index);
+			// If the parent Device allows it, evaluation is deferred until the end of the sub-tick, when the parent
+			// Device evaluates all deferred Gates in batches by operator. Otherwise evaluate straight away.
+			if (m_parent_device_pointer->CanDeferGateEvaluation(m_local_component_index)) {
+				if (!m_deferred_flag) {
+					m_deferred_flag = true;
+					m_parent_device_pointer->DeferGateEvaluation(this);
+				}
+			} else {
+				Evaluate<logging_policy>();
+			}
+		}
 	}
 }
 
+template <class logging_policy>
 void Gate::Evaluate() {
-	// The 'this' below is how we call a method function via it's method function pointer. Assuming the pointer and method
-	// are public, we could call it from outside this object via the syntax:
-	// 		([object variable name].*[object variable name].[member pointer variable name])(arguments);
-	// HOWEVER, from inside the object we use the syntax:
-	//		(this->*[member pointer variable name])(arguments);
-	bool new_state = (this->*m_operator_function_pointer)(m_pins);
+	ApplyEvaluation<logging_policy>(ComputeOutput());
+}
+
+unsigned char Gate::ComputeOutput() {
+	if (m_packed_flag && (m_in_pin_unknown_word == 0)) {
+		// All in pins known, so the output is a plain two-valued function of the packed in pin word.
+		uint64_t in_pin_word = m_in_pin_word;
+		uint64_t in_pin_mask = m_in_pin_mask;
+		switch (m_operator_index) {
+			case GATE_AND:
+				return ((in_pin_word & in_pin_mask) == in_pin_mask);
+			case GATE_NAND:
+				return ((in_pin_word & in_pin_mask) != in_pin_mask);
+			case GATE_OR:
+				return ((in_pin_word & in_pin_mask) != 0);
+			case GATE_NOR:
+				return ((in_pin_word & in_pin_mask) == 0);
+			case GATE_NOT:
+				return ((in_pin_word & 1) == 0);
+		}
+	}
+	// Otherwise summarise the in pins as 'any known low', 'any known high' and 'any X or Z', which is all the
+	// operators need.
+	uint64_t known_low = 0;
+	uint64_t known_high = 0;
+	uint64_t unknown = 0;
+	if (m_packed_flag) {
+		known_low = ~m_in_pin_word & ~m_in_pin_unknown_word & m_in_pin_mask;
+		known_high = m_in_pin_word & ~m_in_pin_unknown_word & m_in_pin_mask;
+		unknown = m_in_pin_unknown_word & m_in_pin_mask;
+	} else {
+		for (const auto& this_pin : m_pins) {
+			if (this_pin.direction == 1) {
+				if (this_pin.unknown) {
+					unknown = 1;
+				} else if (this_pin.state) {
+					known_high = 1;
+				} else {
+					known_low = 1;
+				}
+			}
+		}
+	}
+	return EvaluateOperator(m_operator_index, known_low, known_high, unknown);
+}
+
+unsigned char Gate::EvaluateOperator(const int operator_index, const uint64_t known_low, const uint64_t known_high, const uint64_t unknown) {
+	// Returns a two-bit logic value: bit 0 is the state and bit 1 is set if the output is unknown (X). A Gate input
+	// that is X or Z makes the output X unless a known input decides it (e.g. any known low in pin of an and Gate).
+	// With no unknown in pins this reduces to the usual two-valued operators.
+	bool any_low = (known_low != 0);
+	bool any_high = (known_high != 0);
+	bool any_unknown = (unknown != 0);
+	bool state = false;
+	bool unknown_out = false;
+	switch (operator_index) {
+		case GATE_AND:
+			state = (!any_low && !any_unknown);
+			unknown_out = (!any_low && any_unknown);
+			break;
+		case GATE_NAND:
+			state = any_low;
+			unknown_out = (!any_low && any_unknown);
+			break;
+		case GATE_OR:
+			state = any_high;
+			unknown_out = (!any_high && any_unknown);
+			break;
+		case GATE_NOR:
+			state = (!any_high && !any_unknown);
+			unknown_out = (!any_high && any_unknown);
+			break;
+		case GATE_NOT:
+			state = any_low;
+			unknown_out = any_unknown;
+			break;
+	}
+	return (unsigned char)(state | (unknown_out << 1));
+}
+
+template <class logging_policy>
+void Gate::ApplyEvaluation(const unsigned char new_logic) {
+	m_deferred_flag = false;
 	pin* out_pin = &m_pins[m_out_pin_port_index];
-	if (out_pin->state != new_state) {
-		if (mg_verbose_flag) {
-			std::string message = std::string(KBLD) + KRED + "  ->" + RST + " Gate " + KBLD + m_full_name + RST + " output terminal set to " + BoolToChar(new_state);
-			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
+	bool new_state = (new_logic & 1);
+	bool new_unknown = ((new_logic & 2) != 0);
+	if ((out_pin->state != new_state) || (out_pin->unknown != new_unknown)) {
+		if constexpr (logging_policy::enabled) {
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = std::string(KBLD) + KRED + "  ->" + RST + " Gate " + KBLD + m_full_name + RST + " output terminal set to " + LogicToChar(new_state, new_unknown);
+				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
+			}
 		}
 		// If the gate output has changed add it to the parent Devices propagate_next list, UNLESS this gate
 		// is already queued-up to propagate this tick.
 		out_pin->state = new_state;
+		out_pin->unknown = new_unknown;
 		out_pin->state_changed = true;
 		m_parent_device_pointer->QueueToPropagate(m_local_component_index);
 		// Print output pin changes if we are monitoring this gate.
-		if (m_monitor_on || mg_verbose_flag) {
-			std::string message = std::string(KBLD) + KRED + "  MONITOR: " + RST + KBLD + m_full_name + ":" + m_component_type + " output terminal set to " + BoolToChar(new_state);
-			if (mg_verbose_flag) {
-				message = "~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message;
+		if constexpr (logging_policy::enabled) {
+			if (m_monitor_on || m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = std::string(KBLD) + KRED + "  MONITOR: " + RST + KBLD + m_full_name + ":" + *m_component_type + " output terminal set to " + LogicToChar(new_state, new_unknown);
+				if (m_top_level_sim_pointer->m_verbose_flag) {
+					message = "~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message;
+				}
+				m_top_level_sim_pointer->LogMessage(message);
 			}
-			m_top_level_sim_pointer->LogMessage(message);
 		}
 	}
 }
 
-void Gate::Propagate() {
-	pin* out_pin = &m_pins[m_out_pin_port_index];
-	if (out_pin->state_changed) {
-		if (mg_verbose_flag) {
-			std::string message = std::string(KBLD) + KYEL + "->" + RST + " Gate " + KBLD + m_full_name + RST + " propagating output = " + BoolToChar(out_pin->state);
-			m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
-		}
-		out_pin->state_changed = false;
-		for (const auto& this_connection_descriptor : m_connections) {
-			this_connection_descriptor.target_component_pointer->Set(this_connection_descriptor.target_pin_port_index, out_pin->state);
-		}
-	}
+void Gate::AddToGateBatch(std::vector<gate_batch>& gate_batches, const int deferred_index) {
+	gate_batch& this_batch = gate_batches[m_operator_index];
+	this_batch.in_pin_words.push_back(m_in_pin_word);
+	this_batch.in_pin_unknown_words.push_back(m_in_pin_unknown_word);
+	this_batch.in_pin_masks.push_back(m_in_pin_mask);
+	this_batch.deferred_indices.push_back(deferred_index);
 }
 
-operator_pointer Gate::GetOperatorPointer(std::string const& operator_name) {
-	operator_pointer pointer;
-	if (operator_name == "and") {
-		pointer = &Gate::OperatorAnd;
-	} else if (operator_name == "nand") {
-		pointer = &Gate::OperatorNand;
-	} else if (operator_name == "or") {
-		pointer = &Gate::OperatorOr;
-	} else if (operator_name == "nor") {
-		pointer = &Gate::OperatorNor;
-	} else if (operator_name == "not") {
-		pointer = &Gate::OperatorNot;
+void Gate::EvaluateGateBatch(const int operator_index, gate_batch& batch) {
+	// Branch-free kernels over the packed in pin words of Gates sharing an operator, written so that the compiler
+	// can vectorise them. Each result is a two-bit logic value, as returned by EvaluateOperator().
+	size_t batch_size = batch.in_pin_words.size();
+	batch.results.resize(batch_size);
+	uint64_t const* in_pin_words = batch.in_pin_words.data();
+	uint64_t const* in_pin_unknown_words = batch.in_pin_unknown_words.data();
+	uint64_t const* in_pin_masks = batch.in_pin_masks.data();
+	unsigned char* results = batch.results.data();
+	switch (operator_index) {
+		case GATE_AND:
+			for (size_t i = 0; i < batch_size; i ++) {
+				unsigned char no_low = ((~in_pin_words[i] & ~in_pin_unknown_words[i] & in_pin_masks[i]) == 0);
+				unsigned char any_unknown = ((in_pin_unknown_words[i] & in_pin_masks[i]) != 0);
+				results[i] = (no_low & (any_unknown ^ 1)) | ((no_low & any_unknown) << 1);
+			}
+			break;
+		case GATE_NAND:
+			for (size_t i = 0; i < batch_size; i ++) {
+				unsigned char no_low = ((~in_pin_words[i] & ~in_pin_unknown_words[i] & in_pin_masks[i]) == 0);
+				unsigned char any_unknown = ((in_pin_unknown_words[i] & in_pin_masks[i]) != 0);
+				results[i] = (no_low ^ 1) | ((no_low & any_unknown) << 1);
+			}
+			break;
+		case GATE_OR:
+			for (size_t i = 0; i < batch_size; i ++) {
+				unsigned char no_high = ((in_pin_words[i] & ~in_pin_unknown_words[i] & in_pin_masks[i]) == 0);
+				unsigned char any_unknown = ((in_pin_unknown_words[i] & in_pin_masks[i]) != 0);
+				results[i] = (no_high ^ 1) | ((no_high & any_unknown) << 1);
+			}
+			break;
+		case GATE_NOR:
+			for (size_t i = 0; i < batch_size; i ++) {
+				unsigned char no_high = ((in_pin_words[i] & ~in_pin_unknown_words[i] & in_pin_masks[i]) == 0);
+				unsigned char any_unknown = ((in_pin_unknown_words[i] & in_pin_masks[i]) != 0);
+				results[i] = (no_high & (any_unknown ^ 1)) | ((no_high & any_unknown) << 1);
+			}
+			break;
+		case GATE_NOT:
+			for (size_t i = 0; i < batch_size; i ++) {
+				unsigned char any_unknown = (in_pin_unknown_words[i] & 1);
+				results[i] = ((~in_pin_words[i] & 1) & (any_unknown ^ 1)) | (any_unknown << 1);
+			}
+			break;
 	}
-	return pointer;
 }
 
-bool Gate::OperatorAnd(std::vector<pin> const& pins) {
-	bool output = true;
-	for (const auto& this_pin : pins) {
-		if (this_pin.direction == 1) {
-			output &= this_pin.state;
-		}
+void Gate::Propagate() {
+	if (m_top_level_sim_pointer->UseVerboseLogging()) {
+		PropagateOutput<verbose_logging>();
+	} else {
+		PropagateOutput<quiet_logging>();
 	}
-	return output;
 }
 
-bool Gate::OperatorNand(std::vector<pin> const& pins) {
-	bool output = true;
-	for (const auto& this_pin : pins) {
-		if (this_pin.direction == 1) {
-			output &= this_pin.state;
+template <class logging_policy>
+void Gate::PropagateOutput() {
+	pin* out_pin = &m_pins[m_out_pin_port_index];
+	if (out_pin->state_changed) {
+		if constexpr (logging_policy::enabled) {
+			if (m_top_level_sim_pointer->m_verbose_flag) {
+				std::string message = std::string(KBLD) + KYEL + "->" + RST + " Gate " + KBLD + m_full_name + RST + " propagating output = " + LogicToChar(out_pin->state, out_pin->unknown);
+				m_top_level_sim_pointer->LogMessage("~" + std::to_string(m_parent_device_pointer->GetMessageBranchID()) + ": " + message);
+			}
 		}
-	}
-	output = !output;
-	return output;
-}
-
-bool Gate::OperatorOr(std::vector<pin> const& pins) {
-	bool output = false;
-	for (const auto& this_pin : pins) {
-		if (this_pin.direction == 1) {
-			output |= this_pin.state;
+		out_pin->state_changed = false;
+		for (const auto& this_target : m_fanout.gate_targets) {
+			this_target.target_gate_pointer->SetLogic<logging_policy>(this_target.target_pin_port_index, out_pin->state, out_pin->unknown);
 		}
-	}
-	return output;
-}
-
-bool Gate::OperatorNor(std::vector<pin> const& pins) {
-	bool output = false;
-	for (const auto& this_pin : pins) {
-		if (this_pin.direction == 1) {
-			output |= this_pin.state;
+		for (const auto& this_target : m_fanout.device_targets) {
+			this_target.target_device_pointer->Device::SetLogic<logging_policy>(this_target.target_pin_port_index, out_pin->state, out_pin->unknown);
 		}
 	}
-	output = !output;
-	return output;
 }
 
-bool Gate::OperatorNot(std::vector<pin> const& pins) {
-	bool output = false;
-	for (const auto& this_pin: pins) {
-		if (this_pin.direction == 1) {
-			output = !this_pin.state;
-		}
+// The solver (see Device::SolveWithPolicy()) is built for both logging policies.
+template void Gate::SetLogic<quiet_logging>(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+template void Gate::SetLogic<verbose_logging>(const int pin_port_index, const bool state_to_set, const bool unknown_to_set);
+template void Gate::PropagateOutput<quiet_logging>(void);
+template void Gate::PropagateOutput<verbose_logging>(void);
+template void Gate::Evaluate<quiet_logging>(void);
+template void Gate::Evaluate<verbose_logging>(void);
+template void Gate::ApplyEvaluation<quiet_logging>(const unsigned char new_logic);
+template void Gate::ApplyEvaluation<verbose_logging>(const unsigned char new_logic);
+
+int Gate::GetOperatorIndex(std::string const& operator_name) {
+	int operator_index = GATE_AND;
+	if (operator_name == "nand") {
+		operator_index = GATE_NAND;
+	} else if (operator_name == "or") {
+		operator_index = GATE_OR;
+	} else if (operator_name == "nor") {
+		operator_index = GATE_NOR;
+	} else if (operator_name == "not") {
+		operator_index = GATE_NOT;
 	}
-	return output;
+	return operator_index;
 }
 
 void Gate::PrintPinStates(int max_levels) {
 	std::cout << m_full_name << ": [";
 	for (const auto& in_pin_name: GetSortedInPinNames()) {
 		int in_pin_port_index = GetPinPortIndex(in_pin_name);
-		std::cout << " " << BoolToChar(m_pins[in_pin_port_index].state) << " ";
+		std::cout << " " << LogicToChar(m_pins[in_pin_port_index].state, m_pins[in_pin_port_index].unknown) << " ";
 	}
-	std::cout << "] [ " << BoolToChar(m_pins[m_out_pin_port_index].state) << " ]" << std::endl;
+	std::cout << "] [ " << LogicToChar(m_pins[m_out_pin_port_index].state, m_pins[m_out_pin_port_index].unknown) << " ]" << std::endl;
 }
 
 void Gate::ReportUnConnectedPins() {
-	if (mg_verbose_flag) {
+	if (m_top_level_sim_pointer->m_verbose_flag) {
 		std::string message = "Checking pins for " + m_full_name + " m_local_component_index = " + std::to_string(m_local_component_index);
 		m_top_level_sim_pointer->LogMessage(message);
 	}
@@ -314,7 +547,7 @@ void Gate::ReportUnConnectedPins() {
 		if (this_pin.direction == 1) {
 			if (!this_pin.drive[0]) {
 				// Log undriven Gate in pin.
-				std::string build_error = "Gate " + m_full_name + " in pin " + this_pin.name + " is not driven by any Component.";
+				std::string build_error = "Gate " + m_full_name + " in pin " + *this_pin.name + " is not driven by any Component.";
 				m_top_level_sim_pointer->LogError(build_error);
 			}
 		} else if (this_pin.direction == 2) {
@@ -323,7 +556,7 @@ void Gate::ReportUnConnectedPins() {
 			if (m_nesting_level > 1) {
 				if (!this_pin.drive[1]) {
 					// Log undriving Gate out pin.
-					std::string build_error = "Gate " + m_full_name + " out pin " + this_pin.name + " drives no Component.";
+					std::string build_error = "Gate " + m_full_name + " out pin " + *this_pin.name + " drives no Component.";
 					m_top_level_sim_pointer->LogError(build_error);
 				}
 			}
@@ -333,7 +566,7 @@ void Gate::ReportUnConnectedPins() {
 
 void Gate::PurgeComponent() {
 	std::string header;
-	if (mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "Purging -> GATE : " + m_full_name + " @ " + PointerToString(static_cast<void*>(this));
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -354,7 +587,7 @@ void Gate::PurgeComponent() {
 		// Third  - Clear component entry from parent device's m_components.
 		m_parent_device_pointer->PurgeChildComponentIdentifiers(this);
 	}
-	if (mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "GATE : " + m_full_name + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged.";
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -371,7 +604,7 @@ void Gate::PurgeInboundConnections(Component* target_component_pointer) {
 			new_connections.push_back(this_connection_descriptor);
 		} else {
 			connections_removed ++;
-			if (mg_verbose_destructor_flag) {
+			if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 				std::cout << "Gate " << m_full_name << " removed an out connection to "
 					<< this_connection_descriptor.target_component_pointer->GetFullName() << " in pin "
 					<< this_connection_descriptor.target_component_pointer->GetPinName(this_connection_descriptor.target_pin_port_index) << std::endl;
@@ -379,12 +612,13 @@ void Gate::PurgeInboundConnections(Component* target_component_pointer) {
 		}
 	}
 	if ((new_connections.size() == 0) && (connections_removed > 0)) {
-		if (mg_verbose_destructor_flag) {
+		if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 			std::cout << "Gate " + m_full_name + " out pin drive out set to false." << std::endl;
 		}
 		SetPinDrivenFlag(m_out_pin_port_index, 1, false);
 	}
 	m_connections = new_connections;
+	BuildFanout(m_connections, m_fanout);
 }
 
 void Gate::PurgeOutboundConnections() {
@@ -398,7 +632,7 @@ void Gate::PurgeOutboundConnections() {
 		} else if (pin_direction == 2) {
 			direction = " out";
 		}
-		if (mg_verbose_destructor_flag) {
+		if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 			std::cout << "Component " << target_component_pointer->GetFullName() << direction << " pin "
 				<< target_component_pointer->GetPinName(this_connection_descriptor.target_pin_port_index) << " drive in set to false." << std::endl;
 		}
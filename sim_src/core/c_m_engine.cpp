@@ -36,7 +36,7 @@ MagicEngine::MagicEngine(Device* parent_device_pointer) {
 
 MagicEngine::~MagicEngine() {
 	std::string header;
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "Purging -> MAGICENGINE : " + m_identifier + " @ " + PointerToString(static_cast<void*>(this));
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -44,7 +44,7 @@ MagicEngine::~MagicEngine() {
 	// Then purge the magic_engine_descriptor held by the top-level Simulation.
 	m_top_level_sim_pointer->PurgeMagicEngineDescriptorFromSimulation({m_identifier, this});
 	// ----------------------------------------
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "MAGICENGINE : " + m_identifier + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged.";
 		std::cout << GenerateHeader(header) << std::endl;
 		std::cout << "MagicEngine dtor for " << m_identifier << " @ " << this << std::endl << std::endl;
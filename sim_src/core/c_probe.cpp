@@ -22,6 +22,7 @@
 #include <string>					// std::string.
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::vector
+#include <unordered_map>			// std::unordered_map
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
@@ -46,28 +47,46 @@ Probe::Probe(Simulation* top_level_sim_pointer, std::string const& probe_name, C
 
 Probe::~Probe() {
 	PurgeProbe();
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		std::cout << "Probe dtor for " << m_name << " @ " << this << std::endl << std::endl;
 	}
 }
 
 void Probe::Sample(const int index) {
 	m_this_sample.clear();
+	m_this_unknown_sample.clear();
 	m_timestamps.emplace_back(index);
 	bool pin_state = false;
+	bool any_unknown_flag = false;
 	for (const auto& pin_port_index : m_target_pin_indices) {
 		pin_state = m_target_component_pointer->GetPinState(pin_port_index);
 		m_this_sample.emplace_back(pin_state);
+		bool pin_unknown = m_target_component_pointer->GetPinUnknown(pin_port_index);
+		m_this_unknown_sample.emplace_back(pin_unknown);
+		any_unknown_flag |= pin_unknown;
 	}
 	m_samples.emplace_back(m_this_sample);
+	// X and Z are kept aside (samples stay two-valued), and only for samples that have any, see PrintSamples().
+	if (any_unknown_flag) {
+		m_unknown_samples[m_samples.size() - 1] = m_this_unknown_sample;
+	}
 }
 
 void Probe::Reset() {
 	m_this_sample.clear();
 	m_samples.clear();
+	m_unknown_samples.clear();
 	m_timestamps.clear();
 }
 
+void Probe::DiscardSamplesFrom(const int tick_index) {
+	while ((m_timestamps.size() > 0) && (m_timestamps.back() >= tick_index)) {
+		m_timestamps.pop_back();
+		m_samples.pop_back();
+		m_unknown_samples.erase(m_samples.size());
+	}
+}
+
 void Probe::PreallocateSampleMemory(int number_of_ticks) {
 	size_t current_size = m_samples.size();
 	size_t new_capacity = current_size + number_of_ticks;
@@ -81,18 +100,38 @@ Component* Probe::GetTargetComponentPointer() {
 	return m_target_component_pointer;
 }
 
+void Probe::RemapTargetComponentPointer(std::unordered_map<Component*, Component*> const& pointer_map) {
+	auto this_mapping = pointer_map.find(m_target_component_pointer);
+	if (this_mapping != pointer_map.end()) {
+		m_target_component_pointer = this_mapping->second;
+	}
+}
+
+Probe* Probe::CloneInto(Simulation* top_level_sim_pointer, std::unordered_map<Clock*, Clock*> const& clock_pointer_map) {
+	// Samples taken so far are kept. The target Component is remapped by the cloned Simulation.
+	Probe* cloned_probe_pointer = new Probe(*this);
+	cloned_probe_pointer->m_top_level_sim_pointer = top_level_sim_pointer;
+	cloned_probe_pointer->m_trigger_clock_pointer = clock_pointer_map.at(m_trigger_clock_pointer);
+	cloned_probe_pointer->m_trigger_clock_pointer->AddToProbeList(m_name, cloned_probe_pointer);
+	return cloned_probe_pointer;
+}
+
 void Probe::PrintSamples() {
 	int index = 0;
 	int probe_index = m_probe_every_n_ticks;
 	std::cout << "Probe: " << m_name << " - " << m_target_component_full_name << std::endl;
 	for (const auto& sample: m_samples) {
+		auto unknown_sample = m_unknown_samples.find(index);
 		if (probe_index == m_probe_every_n_ticks) {
 			probe_index = 0;
 			std::string header = "T: " + std::to_string(index) + "  ";
 			std::cout << header;
 			int column_index = 1;
-			for (const auto& sub_sample: sample) {
-				if (sub_sample) {
+			for (size_t pin_index = 0; pin_index < sample.size(); pin_index ++) {
+				bool sub_sample = sample[pin_index];
+				if ((unknown_sample != m_unknown_samples.end()) && unknown_sample->second[pin_index]) {
+					std::cout << " " << LogicToChar(sub_sample, true);
+				} else if (sub_sample) {
 					std::cout << " " << m_output_characters[1];
 				} else {
 					std::cout << " " << m_output_characters[0];
@@ -118,7 +157,7 @@ std::vector<std::vector<bool>> Probe::GetSamples(void) {
 
 void Probe::PurgeProbe() {
 	std::string header;
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "Purging -> PROBE : " + m_name + " @ " + PointerToString(static_cast<void*>(this)) ;
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -128,7 +167,7 @@ void Probe::PurgeProbe() {
 		// ...then parent Simulation's m_probes vector.
 		m_top_level_sim_pointer->PurgeProbeDescriptorFromSimulation(this);
 	}
-	if (m_top_level_sim_pointer->mg_verbose_destructor_flag) {
+	if (m_top_level_sim_pointer->m_verbose_destructor_flag) {
 		header =  "PROBE : " + m_name + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged." ;
 		std::cout << GenerateHeader(header) << std::endl;
 	}
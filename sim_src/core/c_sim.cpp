@@ -25,74 +25,823 @@
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::v.ctor
 #include <ctime>					// time().
-#include <cstdlib>					// srand().
+#include <atomic>					// std::atomic.
 #include <mutex>					// std::mutex, std::unique_lock.
-#include <algorithm>				// std::equal.
+#include <functional>				// std::bind.
+#include <algorithm>				// std::equal, std::min.
+#include <deque>					// std::deque.
+#include <map>						// std::map.
+#include <limits>					// std::numeric_limits.
+#include <thread>					// std::this_thread::yield().
 
 #include <termios.h>				// terminal settings.
 #include <unistd.h>					// POSIX bits.
 #include <sys/ioctl.h>				// ioctl().
+#include <sys/mman.h>				// mmap(), munmap().
+#include <sys/wait.h>				// waitpid().
+#include <fcntl.h>					// open().
+#include <cstdio>					// fflush().
+#include <cstring>					// std::memcpy.
+#include <csignal>					// kill().
 
 #include "c_core.h"					// Core simulator functionality
 #include "void_thread_pool.hpp"
 #include "utils.h"
 #include "colors.h"
 
+thread_local solve_event_buffer* Simulation::mg_solve_event_buffer = nullptr;
+thread_local elaboration_slot* Simulation::mg_elaboration_slot = nullptr;
+
 Simulation::Simulation(std::string const& simulation_name, bool verbose_output_flag, solver_configuration solver_conf, int max_propagations)
  : Device(this, simulation_name, "simulation", {}, {}, false, {}, max_propagations) {
 	m_next_new_CUID = 1;
 	m_simulation_running = false;
 	m_global_tick_index = 0;
-	mg_verbose_flag = verbose_output_flag;
-	mg_verbose_destructor_flag = false;					// Set to true to check destructor messages.
+	m_verbose_flag = verbose_output_flag;
+	m_verbose_destructor_flag = false;					// Set to true to check destructor messages.
 	m_use_threaded_solver = solver_conf.use_threaded_solver;
 	m_threaded_solve_nesting_level = solver_conf.threaded_solve_nesting_level;
+	m_use_unknown_states = solver_conf.use_unknown_states;
+	m_use_persistent_workers = solver_conf.use_persistent_workers;
+	m_use_cost_model = (m_use_threaded_solver && solver_conf.use_cost_model);
+	m_profiling_solve_costs = m_use_cost_model;
+	m_use_parallel_build = solver_conf.use_parallel_build;
+	m_min_offload_work = solver_conf.min_offload_work;
+	m_min_parallel_gain = solver_conf.min_parallel_gain;
+	// The Device constructor ran before the above were set, so decide here whether top-level Devices are solved in parallel.
+	m_solve_children_in_own_threads = (m_use_threaded_solver && !m_use_cost_model && (m_threaded_solve_nesting_level == 0));
+	if (solver_conf.seed != 0) {
+		SetSeed(solver_conf.seed);
+	} else {
+		SetSeed(uint64_t(time(0)));
+	}
 	std::string message = "\n" + GenerateHeader("Simulation build started.") + "\n";
 	LogMessage(message);
-	if (mg_verbose_flag == false) {
+	if (m_verbose_flag == false) {
 		std::string message = "(Simulation verbose output is off)";
 		LogMessage(message);
+	} else {
+		std::string message = "Initial state seed = " + std::to_string(m_seed);
+		LogMessage(message);
 	}
-	// Start up the Simulation's solver threadpool.
-	if (m_use_threaded_solver) {
+	// Start up the Simulation's solver threadpool (also used to build Devices in parallel).
+	if (m_use_threaded_solver || m_use_parallel_build) {
+		m_thread_pool_pointer = new VoidThreadPool(false);
+	}
+}
+
+Simulation::Simulation(Simulation const& original_simulation)
+ : Device(original_simulation) {
+	// Only the Simulation's own state is copied here, the Components, Clocks and Probes are copied by Clone().
+	m_top_level_sim_pointer = this;
+	m_parent_device_pointer = this;
+	m_next_new_CUID = original_simulation.m_next_new_CUID.load();
+	m_simulation_running = false;
+	m_global_tick_index = original_simulation.m_global_tick_index;
+	m_verbose_flag = original_simulation.m_verbose_flag;
+	m_verbose_destructor_flag = original_simulation.m_verbose_destructor_flag;
+	m_monitored_component_count = original_simulation.m_monitored_component_count.load();
+	m_use_threaded_solver = original_simulation.m_use_threaded_solver;
+	m_threaded_solve_nesting_level = original_simulation.m_threaded_solve_nesting_level;
+	m_use_unknown_states = original_simulation.m_use_unknown_states;
+	m_use_persistent_workers = original_simulation.m_use_persistent_workers;
+	m_use_cost_model = original_simulation.m_use_cost_model;
+	m_profiling_solve_costs = original_simulation.m_profiling_solve_costs;
+	m_cost_model_ticks_profiled = original_simulation.m_cost_model_ticks_profiled;
+	m_use_parallel_build = original_simulation.m_use_parallel_build;
+	m_min_offload_work = original_simulation.m_min_offload_work;
+	m_min_parallel_gain = original_simulation.m_min_parallel_gain;
+	m_seed = original_simulation.m_seed;
+	m_random_generator = original_simulation.m_random_generator;
+	// Each clone has it's own solver threadpool.
+	if (m_use_threaded_solver || m_use_parallel_build) {
 		m_thread_pool_pointer = new VoidThreadPool(false);
 	}
-	srand(time(0));
 }
 
 Simulation::~Simulation() {
-	if (m_use_threaded_solver) {
+	if (m_thread_pool_pointer != 0) {
 		delete m_thread_pool_pointer;
 	}
 	PurgeComponent();
-	if (mg_verbose_destructor_flag) {
+	if (m_verbose_destructor_flag) {
 		std::cout << "Simulation dtor for " << m_full_name << " @ " << this << std::endl;
 	}
 }
 
+Simulation* Simulation::Clone() {
+	// Copy the built netlist and it's current state into a new, independent Simulation (owned by the caller), without
+	// calling any Build() or Stabilise() methods. Returns null if the Simulation can not be cloned.
+	if (m_simulation_running) {
+		std::string error_message = "Simulation " + m_full_name + " can not be cloned while it is running.";
+		LogError(error_message);
+		return 0;
+	}
+	if (!m_magic_engines.empty()) {
+		// Magic Devices hold state outside of the Component tree (in their MagicEngines).
+		std::string error_message = "Simulation " + m_full_name + " can not be cloned as it contains magic Devices.";
+		LogError(error_message);
+		return 0;
+	}
+	Simulation* cloned_simulation_pointer = new Simulation(*this);
+	std::unordered_map<Component*, Component*> pointer_map;
+	pointer_map[this] = cloned_simulation_pointer;
+	cloned_simulation_pointer->CloneChildComponents(pointer_map);
+	cloned_simulation_pointer->RemapSubtreeConnections(pointer_map);
+	std::unordered_map<Clock*, Clock*> clock_pointer_map;
+	for (const auto& this_clock_descriptor : m_clocks) {
+		Clock* cloned_clock_pointer = this_clock_descriptor.clock_pointer->CloneInto(cloned_simulation_pointer);
+		clock_pointer_map[this_clock_descriptor.clock_pointer] = cloned_clock_pointer;
+		cloned_simulation_pointer->m_clocks.push_back({this_clock_descriptor.clock_name, cloned_clock_pointer});
+	}
+	for (const auto& this_probe_descriptor : m_probes) {
+		Probe* cloned_probe_pointer = this_probe_descriptor.probe_pointer->CloneInto(cloned_simulation_pointer, clock_pointer_map);
+		cloned_simulation_pointer->m_probes.push_back({this_probe_descriptor.probe_name, cloned_probe_pointer});
+	}
+	cloned_simulation_pointer->RemapComponentPointers(pointer_map);
+	return cloned_simulation_pointer;
+}
+
+std::vector<branch_result> Simulation::Branch(const int branch_count, std::function<void(Simulation*, const int)> const& branch_function,
+	std::vector<std::string> const& probe_names, const size_t result_capacity) {
+	// Fork the process once per branch at the current tick. Each child process calls branch_function with this
+	// Simulation (it's own copy-on-write copy, so a branch only costs the pages it goes on to change) and the branch
+	// index, then passes the named Probes' samples back through shared memory and exits. This Simulation is left as
+	// it was. Only the calling thread is copied into the children, so no other thread may be using the simulator.
+	std::vector<branch_result> branch_results(branch_count, {false, {}});
+	if (m_simulation_running) {
+		std::string error_message = "Simulation " + m_full_name + " can not be branched while it is running.";
+		LogError(error_message);
+		return branch_results;
+	}
+	if (!m_magic_engines.empty()) {
+		// A forked MagicEngine keeps the same FIFOs and child process (eg a SimpleTerminal's), so every branch would
+		// share them.
+		std::string error_message = "Simulation " + m_full_name + " can not be branched as it contains magic Devices.";
+		LogError(error_message);
+		return branch_results;
+	}
+	// Each branch's region starts with the packed size of it's results, left at 0 if the branch does not finish.
+	size_t region_size = sizeof(uint64_t) + result_capacity;
+	void* shared_memory = mmap(nullptr, region_size * branch_count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared_memory == MAP_FAILED) {
+		std::string error_message = "Simulation " + m_full_name + " could not map " + std::to_string(region_size * branch_count) + " bytes for branch results.";
+		LogError(error_message);
+		return branch_results;
+	}
+	// Anything still buffered would otherwise be printed once by every branch.
+	std::cout.flush();
+	fflush(stdout);
+	std::vector<pid_t> branch_pids(branch_count, -1);
+	for (int branch_index = 0; branch_index < branch_count; branch_index ++) {
+		pid_t branch_pid = fork();
+		if (branch_pid == 0) {
+			unsigned char* branch_region = static_cast<unsigned char*>(shared_memory) + (branch_index * region_size);
+			// The solver threadpool's workers were not copied into this process, so it needs a new one (the old one
+			// can not be shut down, and is never used again). Branches leave the keyboard to the parent.
+			if (m_thread_pool_pointer != 0) {
+				m_thread_pool_pointer = new VoidThreadPool(false);
+			}
+			int null_descriptor = open("/dev/null", O_RDONLY);
+			if (null_descriptor >= 0) {
+				dup2(null_descriptor, 0);
+				close(null_descriptor);
+			}
+			branch_function(this, branch_index);
+			std::vector<std::vector<std::vector<bool>>> probed_states = {};
+			if (probe_names.size() > 0) {
+				probed_states = GetProbedStates(probe_names);
+			}
+			uint64_t packed_size = PackProbedStates(probed_states, branch_region + sizeof(uint64_t), result_capacity);
+			std::cout.flush();
+			fflush(stdout);
+			if (packed_size > result_capacity) {
+				_exit(2);
+			}
+			std::memcpy(branch_region, &packed_size, sizeof(packed_size));
+			_exit(0);
+		}
+		branch_pids[branch_index] = branch_pid;
+		if (branch_pid < 0) {
+			std::string error_message = "Simulation " + m_full_name + " could not fork branch " + std::to_string(branch_index) + ".";
+			LogError(error_message);
+		}
+	}
+	for (int branch_index = 0; branch_index < branch_count; branch_index ++) {
+		if (branch_pids[branch_index] < 0) {
+			continue;
+		}
+		int branch_status = 0;
+		waitpid(branch_pids[branch_index], &branch_status, 0);
+		unsigned char* branch_region = static_cast<unsigned char*>(shared_memory) + (branch_index * region_size);
+		uint64_t packed_size = 0;
+		std::memcpy(&packed_size, branch_region, sizeof(packed_size));
+		if (WIFEXITED(branch_status) && (WEXITSTATUS(branch_status) == 0) && (packed_size > 0)) {
+			branch_results[branch_index].completed_flag = true;
+			branch_results[branch_index].probed_states = UnpackProbedStates(branch_region + sizeof(uint64_t));
+		} else if (WIFEXITED(branch_status) && (WEXITSTATUS(branch_status) == 2)) {
+			std::string error_message = "Simulation " + m_full_name + " branch " + std::to_string(branch_index) + " Probe samples exceeded the result capacity of " + std::to_string(result_capacity) + " bytes.";
+			LogError(error_message);
+		} else {
+			std::string error_message = "Simulation " + m_full_name + " branch " + std::to_string(branch_index) + " did not complete.";
+			LogError(error_message);
+		}
+	}
+	munmap(shared_memory, region_size * branch_count);
+	return branch_results;
+}
+
+std::vector<std::vector<std::vector<bool>>> Simulation::RunPartitioned(const int number_of_ticks, const int partition_count, const int optimistic_window,
+	const size_t result_capacity) {
+	// Run number_of_ticks ticks from tick 0 (as Run()) with the top-level Devices split, balanced by size, across
+	// partition_count forked processes. Each process solves only it's own Devices, on it's own copy-on-write copy of
+	// this Simulation. Within a tick the processes solve in rounds: after each round they swap the in pin changes of
+	// each other's Devices through lock-free rings in shared memory, meet at a barrier, and go again until a round
+	// sends nothing. With an optimistic_window above 0 the processes instead run up to that many ticks ahead of each
+	// other, rolling back when a change arrives for a tick they have already run (see RunPartitionOptimistically()),
+	// which suits designs with little traffic between partitions. Returns the samples of every Probe (as
+	// GetProbedStates({"all"})), each taken by the process that owns the Probe's target. This Simulation is left as it was.
+	std::vector<std::vector<std::vector<bool>>> probed_states = {};
+	CollectLoggedMessages();
+	if (m_simulation_running || (m_error_messages.size() > 0)) {
+		std::string error_message = "Simulation " + m_full_name + " can not be partitioned while it is running or has errors.";
+		LogError(error_message);
+		return probed_states;
+	}
+	if (!m_magic_engines.empty()) {
+		// Magic Devices are updated by their MagicEngines outside of the Component tree, so they can not be split up.
+		std::string error_message = "Simulation " + m_full_name + " can not be partitioned as it contains magic Devices.";
+		LogError(error_message);
+		return probed_states;
+	}
+	int top_level_component_count = GetLocalComponentCount();
+	std::vector<double> device_costs = {};
+	for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+		Component* this_component_pointer = GetChildComponentPointer(local_component_index);
+		if (!this_component_pointer->GetDeviceFlag()) {
+			std::string error_message = "Simulation " + m_full_name + " can not be partitioned as top-level Component " + this_component_pointer->GetFullName() + " is not a Device.";
+			LogError(error_message);
+			return probed_states;
+		}
+		device_costs.push_back(static_cast<Device*>(this_component_pointer)->CountSubtreeComponents());
+	}
+	std::vector<int> device_partitions = PartitionByCost(device_costs, partition_count);
+	// Each Probe is sampled by the partition that owns the top-level Device it's target is in.
+	std::vector<int> probe_partitions = {};
+	for (const auto& this_probe_descriptor : m_probes) {
+		std::string target_full_name = this_probe_descriptor.probe_pointer->GetTargetComponentPointer()->GetFullName();
+		int probe_partition = 0;
+		if (target_full_name != m_full_name) {
+			std::string top_level_name = target_full_name.substr(m_full_name.size() + 1);
+			top_level_name = top_level_name.substr(0, top_level_name.find(":"));
+			probe_partition = device_partitions[GetChildComponentPointer(top_level_name)->GetLocalComponentIndex()];
+		}
+		probe_partitions.push_back(probe_partition);
+	}
+	// Shared memory layout - the barrier, the shared flags (three sets of round flags, the GVT request flag, then the
+	// published, error and live ticks of each partition, see RunPartitionOptimistically()), then a ring from every
+	// partition to every other one, then a result region per partition (the packed size of it's Probe samples, then the
+	// samples). Each round a partition sends at most one message per in pin of the receiving partition's Devices, and the
+	// rings are drained every round. Optimistic partitions hold back what the rings have no room for.
+	std::vector<uint64_t> partition_in_pin_counts(partition_count, 0);
+	for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+		partition_in_pin_counts[device_partitions[local_component_index]] += static_cast<Device*>(GetChildComponentPointer(local_component_index))->GetInPinCount();
+	}
+	const size_t alignment = 64;
+	int shared_flag_count = 4 + (3 * partition_count);
+	size_t control_size = alignment + ((((shared_flag_count * sizeof(std::atomic<int>)) + alignment - 1) / alignment) * alignment);
+	std::vector<size_t> ring_offsets(partition_count * partition_count, 0);
+	size_t mapping_size = control_size;
+	for (int source_index = 0; source_index < partition_count; source_index ++) {
+		for (int target_index = 0; target_index < partition_count; target_index ++) {
+			if (source_index != target_index) {
+				ring_offsets[(source_index * partition_count) + target_index] = mapping_size;
+				size_t ring_size = VoidSPSCRing<boundary_pin_message>::RequiredBytes((partition_in_pin_counts[target_index] * 2) + 1);
+				mapping_size += ((ring_size + alignment - 1) / alignment) * alignment;
+			}
+		}
+	}
+	size_t result_offset = mapping_size;
+	size_t region_size = ((sizeof(uint64_t) + result_capacity + alignment - 1) / alignment) * alignment;
+	mapping_size += region_size * partition_count;
+	void* shared_memory = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared_memory == MAP_FAILED) {
+		std::string error_message = "Simulation " + m_full_name + " could not map " + std::to_string(mapping_size) + " bytes for a partitioned run.";
+		LogError(error_message);
+		return probed_states;
+	}
+	unsigned char* shared_bytes = static_cast<unsigned char*>(shared_memory);
+	VoidSharedSpinBarrier* barrier_pointer = new (shared_bytes) VoidSharedSpinBarrier(partition_count);
+	std::atomic<int>* shared_flags = reinterpret_cast<std::atomic<int>*>(shared_bytes + alignment);
+	for (int flag_index = 0; flag_index < shared_flag_count; flag_index ++) {
+		new (&shared_flags[flag_index]) std::atomic<int>(0);
+	}
+	std::vector<VoidSPSCRing<boundary_pin_message>*> rings(partition_count * partition_count, nullptr);
+	for (int source_index = 0; source_index < partition_count; source_index ++) {
+		for (int target_index = 0; target_index < partition_count; target_index ++) {
+			if (source_index != target_index) {
+				int ring_index = (source_index * partition_count) + target_index;
+				rings[ring_index] = VoidSPSCRing<boundary_pin_message>::CreateAt(shared_bytes + ring_offsets[ring_index], (partition_in_pin_counts[target_index] * 2) + 1);
+			}
+		}
+	}
+	// Anything still buffered would otherwise be printed once by every partition.
+	std::cout.flush();
+	fflush(stdout);
+	std::vector<pid_t> partition_pids(partition_count, -1);
+	for (int partition_index = 0; partition_index < partition_count; partition_index ++) {
+		pid_t partition_pid = fork();
+		if (partition_pid == 0) {
+			unsigned char* partition_region = shared_bytes + result_offset + (partition_index * region_size);
+			// As Branch(), the solver threadpool needs replacing and the keyboard is left to the parent.
+			if (m_thread_pool_pointer != 0) {
+				m_thread_pool_pointer = new VoidThreadPool(false);
+			}
+			int null_descriptor = open("/dev/null", O_RDONLY);
+			if (null_descriptor >= 0) {
+				dup2(null_descriptor, 0);
+				close(null_descriptor);
+			}
+			RunPartition(partition_index, partition_count, number_of_ticks, optimistic_window, device_partitions, barrier_pointer, shared_flags, rings);
+			std::vector<std::vector<std::vector<bool>>> owned_probed_states = {};
+			for (size_t probe_index = 0; probe_index < m_probes.size(); probe_index ++) {
+				if (probe_partitions[probe_index] == partition_index) {
+					owned_probed_states.emplace_back(m_probes[probe_index].probe_pointer->GetSamples());
+				}
+			}
+			uint64_t packed_size = PackProbedStates(owned_probed_states, partition_region + sizeof(uint64_t), result_capacity);
+			std::cout.flush();
+			fflush(stdout);
+			if (packed_size > result_capacity) {
+				_exit(2);
+			}
+			std::memcpy(partition_region, &packed_size, sizeof(packed_size));
+			_exit(m_error_messages.empty() ? 0 : 1);
+		}
+		partition_pids[partition_index] = partition_pid;
+		if (partition_pid < 0) {
+			std::string error_message = "Simulation " + m_full_name + " could not fork partition " + std::to_string(partition_index) + ".";
+			LogError(error_message);
+		}
+	}
+	// Partitions wait on each other at every round, so if one is missing or dies the rest can never finish.
+	bool all_completed_flag = true;
+	for (int partition_index = 0; partition_index < partition_count; partition_index ++) {
+		if (partition_pids[partition_index] < 0) {
+			all_completed_flag = false;
+		}
+	}
+	int waiting_count = 0;
+	for (const auto& this_partition_pid : partition_pids) {
+		if (this_partition_pid > 0) {
+			if (!all_completed_flag) {
+				kill(this_partition_pid, SIGKILL);
+			}
+			waiting_count ++;
+		}
+	}
+	std::vector<int> partition_statuses(partition_count, -1);
+	while (waiting_count > 0) {
+		for (int partition_index = 0; partition_index < partition_count; partition_index ++) {
+			if ((partition_pids[partition_index] <= 0) || (partition_statuses[partition_index] != -1)) {
+				continue;
+			}
+			int partition_status = 0;
+			if (waitpid(partition_pids[partition_index], &partition_status, WNOHANG) != partition_pids[partition_index]) {
+				continue;
+			}
+			partition_statuses[partition_index] = partition_status;
+			waiting_count --;
+			if (!(WIFEXITED(partition_status) && (WEXITSTATUS(partition_status) == 0))) {
+				all_completed_flag = false;
+			}
+			// A partition stopped by errors stops the others at the same round, one that crashed leaves them stuck.
+			if (!WIFEXITED(partition_status)) {
+				for (int other_partition_index = 0; other_partition_index < partition_count; other_partition_index ++) {
+					if ((partition_pids[other_partition_index] > 0) && (partition_statuses[other_partition_index] == -1)) {
+						kill(partition_pids[other_partition_index], SIGKILL);
+					}
+				}
+			}
+		}
+		if (waiting_count > 0) {
+			usleep(1000);
+		}
+	}
+	std::vector<std::vector<std::vector<std::vector<bool>>>> partition_probed_states(partition_count);
+	for (int partition_index = 0; partition_index < partition_count; partition_index ++) {
+		int partition_status = partition_statuses[partition_index];
+		unsigned char* partition_region = shared_bytes + result_offset + (partition_index * region_size);
+		if (WIFEXITED(partition_status) && (WEXITSTATUS(partition_status) == 0)) {
+			partition_probed_states[partition_index] = UnpackProbedStates(partition_region + sizeof(uint64_t));
+		} else if (WIFEXITED(partition_status) && (WEXITSTATUS(partition_status) == 1)) {
+			std::string error_message = "Simulation " + m_full_name + " partition " + std::to_string(partition_index) + " stopped with errors.";
+			LogError(error_message);
+		} else if (WIFEXITED(partition_status) && (WEXITSTATUS(partition_status) == 2)) {
+			std::string error_message = "Simulation " + m_full_name + " partition " + std::to_string(partition_index) + " Probe samples exceeded the result capacity of " + std::to_string(result_capacity) + " bytes.";
+			LogError(error_message);
+		} else if (partition_pids[partition_index] > 0) {
+			std::string error_message = "Simulation " + m_full_name + " partition " + std::to_string(partition_index) + " did not complete.";
+			LogError(error_message);
+		}
+	}
+	munmap(shared_memory, mapping_size);
+	if (!all_completed_flag) {
+		return probed_states;
+	}
+	std::vector<size_t> next_owned_probe_indices(partition_count, 0);
+	for (size_t probe_index = 0; probe_index < m_probes.size(); probe_index ++) {
+		int probe_partition = probe_partitions[probe_index];
+		probed_states.emplace_back(std::move(partition_probed_states[probe_partition][next_owned_probe_indices[probe_partition]]));
+		next_owned_probe_indices[probe_partition] ++;
+	}
+	return probed_states;
+}
+
+void Simulation::RunPartition(const int partition_index, const int partition_count, const int number_of_ticks, const int optimistic_window,
+	std::vector<int> const& device_partitions, VoidSharedSpinBarrier* barrier_pointer, std::atomic<int>* shared_flags,
+	std::vector<VoidSPSCRing<boundary_pin_message>*> const& rings) {
+	// The solver loop of one process of RunPartitioned(). Round flags are OR-ed together by all the partitions: bit 0
+	// is set if anything was sent, bit 1 if a partition has logged errors. Three sets of flags are rotated through, so
+	// that partition 0 can clear the set for the next round but one while the others may still be reading this one's.
+	std::atomic<int>* round_flags = shared_flags;
+	int top_level_component_count = GetLocalComponentCount();
+	std::vector<Device*> device_pointers = {};
+	m_remote_child_flags.assign(top_level_component_count, false);
+	for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+		device_pointers.push_back(static_cast<Device*>(GetChildComponentPointer(local_component_index)));
+		m_remote_child_flags[local_component_index] = (device_partitions[local_component_index] != partition_index);
+	}
+	m_simulation_running = true;
+	m_global_tick_index = 0;
+	for (const auto& this_clock_descriptor : m_clocks) {
+		this_clock_descriptor.clock_pointer->Reset();
+	}
+	for (const auto& this_probe_descriptor : m_probes) {
+		this_probe_descriptor.probe_pointer->PreallocateSampleMemory(number_of_ticks);
+	}
+	StartPersistentWorkers();
+	if (optimistic_window > 0) {
+		RunPartitionOptimistically(partition_index, partition_count, number_of_ticks, optimistic_window, device_pointers, device_partitions,
+			barrier_pointer, shared_flags, rings
+		);
+	} else {
+		std::vector<boundary_pin_message> boundary_pin_messages = {};
+		int round_index = 0;
+		for (int tick_index = 0; tick_index < number_of_ticks; tick_index ++) {
+			for (const auto& this_clock_descriptor : m_clocks) {
+				this_clock_descriptor.clock_pointer->Tick();
+			}
+			// Every partition ticks every Clock, so Clock-driven in pin changes of remote Devices do not need sending.
+			for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+				if (m_remote_child_flags[local_component_index]) {
+					device_pointers[local_component_index]->CollectChangedInPins(boundary_pin_messages, m_global_tick_index);
+				}
+			}
+			boundary_pin_messages.clear();
+			int round_result = 0;
+			while (true) {
+				Solve(false, m_CUID);
+				for (const auto& this_local_device_index : m_boundary_device_indices) {
+					device_pointers[this_local_device_index]->CollectChangedInPins(boundary_pin_messages, m_global_tick_index);
+				}
+				m_boundary_device_indices.clear();
+				int round_bits = 0;
+				for (const auto& this_message : boundary_pin_messages) {
+					int target_index = device_partitions[this_message.local_component_index];
+					if (!rings[(partition_index * partition_count) + target_index]->TryPush(this_message)) {
+						std::string error_message = "Simulation " + m_full_name + " partition " + std::to_string(partition_index) + " boundary ring to partition " + std::to_string(target_index) + " overflowed.";
+						LogError(error_message);
+						break;
+					}
+				}
+				if (boundary_pin_messages.size() > 0) {
+					round_bits |= 1;
+					boundary_pin_messages.clear();
+				}
+				CollectLoggedMessages();
+				if (m_error_messages.size() > 0) {
+					round_bits |= 2;
+				}
+				round_flags[round_index % 3].fetch_or(round_bits, std::memory_order_acq_rel);
+				barrier_pointer->ArriveAndWait();
+				if (partition_index == 0) {
+					round_flags[(round_index + 2) % 3].store(0, std::memory_order_relaxed);
+				}
+				for (int source_index = 0; source_index < partition_count; source_index ++) {
+					if (source_index == partition_index) {
+						continue;
+					}
+					boundary_pin_message this_message;
+					while (rings[(source_index * partition_count) + partition_index]->TryPop(this_message)) {
+						if (this_message.unknown) {
+							device_pointers[this_message.local_component_index]->SetUnknown(this_message.pin_port_index, this_message.state);
+						} else {
+							device_pointers[this_message.local_component_index]->Set(this_message.pin_port_index, this_message.state);
+						}
+					}
+				}
+				round_result = round_flags[round_index % 3].load(std::memory_order_acquire);
+				round_index ++;
+				if ((round_result & 1) == 0 || (round_result & 2)) {
+					break;
+				}
+			}
+			if (round_result & 2) {
+				break;
+			}
+			CheckProbeTriggers();
+			PrintAndClearMessages();
+			m_global_tick_index += 1;
+		}
+	}
+	StopPersistentWorkers();
+	m_simulation_running = false;
+	PrintErrorMessages();
+}
+
+void Simulation::RunPartitionOptimistically(const int partition_index, const int partition_count, const int number_of_ticks, const int optimistic_window,
+	std::vector<Device*> const& device_pointers, std::vector<int> const& device_partitions, VoidSharedSpinBarrier* barrier_pointer,
+	std::atomic<int>* shared_flags, std::vector<VoidSPSCRing<boundary_pin_message>*> const& rings) {
+	// Time Warp solver loop of one process of RunPartitioned(). The partition runs ahead, up to optimistic_window ticks
+	// past the GVT (global virtual time, the earliest tick that any partition could still have to run again), saving it's
+	// state at the start of every tick. Each tick it applies the in pin changes the other partitions sent for that tick
+	// once it has solved it's own Clock edges, as in a round of the conservative loop, and solves again. The changes it
+	// sends on are the complete list for the tick, and are only sent again if a later run of the tick makes a different
+	// list. A list arriving for a tick the partition has already run rolls it back to the start of that tick.
+	// When a partition can not run any further ahead it asks for the GVT to be moved on. All the partitions then stop at
+	// the barrier, take in everything sent so far and publish the earliest tick they could still be rolled back to. State
+	// and messages from before the GVT are no longer needed. Errors only stop the run once the GVT passes their tick, as
+	// until then they may come from a tick that is rolled back.
+	std::atomic<int>* gvt_request = &shared_flags[3];
+	std::atomic<int>* published_ticks = &shared_flags[4];
+	std::atomic<int>* error_ticks = &shared_flags[4 + partition_count];
+	std::atomic<int>* live_ticks = &shared_flags[4 + (2 * partition_count)];
+	const int no_error_tick = std::numeric_limits<int>::max();
+	int top_level_component_count = GetLocalComponentCount();
+	std::deque<partition_snapshot> snapshots = {};
+	std::vector<std::vector<unsigned char>> spare_states = {};
+	// Changes by tick, received from and sent to each other partition.
+	std::vector<std::map<int, std::vector<boundary_pin_message>>> received_messages(partition_count);
+	std::vector<std::map<int, std::vector<boundary_pin_message>>> sent_messages(partition_count);
+	std::vector<std::deque<boundary_pin_message>> outboxes(partition_count);
+	std::vector<std::vector<boundary_pin_message>> tick_messages(partition_count);
+	std::vector<boundary_pin_message> boundary_pin_messages = {};
+	int local_tick = 0;
+	int gvt = 0;
+	int error_tick = no_error_tick;
+	auto roll_back_to = [&](const int rollback_tick) {
+		// Snapshots after rollback_tick are of a future that no longer happens.
+		while ((snapshots.size() > 0) && (snapshots.back().tick_index > rollback_tick)) {
+			spare_states.emplace_back(std::move(snapshots.back().state));
+			snapshots.pop_back();
+		}
+		if ((snapshots.size() == 0) || (snapshots.back().tick_index != rollback_tick)) {
+			std::string error_message = "Simulation " + m_full_name + " partition " + std::to_string(partition_index) + " could not roll back to tick " + std::to_string(rollback_tick) + ".";
+			LogError(error_message);
+			error_tick = -1;
+			return;
+		}
+		RestorePartitionState(snapshots.back().state);
+		spare_states.emplace_back(std::move(snapshots.back().state));
+		snapshots.pop_back();
+		for (const auto& this_clock_descriptor : m_clocks) {
+			this_clock_descriptor.clock_pointer->RewindTo(rollback_tick);
+		}
+		CollectLoggedMessages();
+		if (error_tick >= rollback_tick) {
+			m_error_messages.clear();
+			error_tick = no_error_tick;
+		}
+		m_global_tick_index = rollback_tick;
+		local_tick = rollback_tick;
+		live_ticks[partition_index].store(local_tick, std::memory_order_relaxed);
+	};
+	auto receive_messages = [&]() {
+		int rollback_tick = local_tick;
+		for (int source_index = 0; source_index < partition_count; source_index ++) {
+			if (source_index == partition_index) {
+				continue;
+			}
+			boundary_pin_message this_message;
+			while (rings[(source_index * partition_count) + partition_index]->TryPop(this_message)) {
+				std::vector<boundary_pin_message>& this_tick_messages = received_messages[source_index][this_message.tick_index];
+				if (this_message.pin_port_index < 0) {
+					this_tick_messages.clear();
+				} else {
+					this_tick_messages.push_back(this_message);
+				}
+				rollback_tick = std::min(rollback_tick, this_message.tick_index);
+			}
+		}
+		if ((rollback_tick < local_tick) && (error_tick != -1)) {
+			roll_back_to(rollback_tick);
+		}
+	};
+	while (true) {
+		for (int target_index = 0; target_index < partition_count; target_index ++) {
+			std::deque<boundary_pin_message>& this_outbox = outboxes[target_index];
+			while ((this_outbox.size() > 0) && rings[(partition_index * partition_count) + target_index]->TryPush(this_outbox.front())) {
+				this_outbox.pop_front();
+			}
+		}
+		receive_messages();
+		if (gvt_request->load(std::memory_order_acquire) != 0) {
+			barrier_pointer->ArriveAndWait();
+			// Nothing is sent until the GVT is found, so everything in flight is now in the rings or the outboxes.
+			receive_messages();
+			int published_tick = local_tick;
+			for (const auto& this_outbox : outboxes) {
+				for (const auto& this_message : this_outbox) {
+					published_tick = std::min(published_tick, this_message.tick_index);
+				}
+			}
+			published_ticks[partition_index].store(published_tick, std::memory_order_relaxed);
+			error_ticks[partition_index].store(error_tick, std::memory_order_relaxed);
+			barrier_pointer->ArriveAndWait();
+			bool stop_flag = false;
+			gvt = number_of_ticks;
+			for (int other_partition_index = 0; other_partition_index < partition_count; other_partition_index ++) {
+				gvt = std::min(gvt, published_ticks[other_partition_index].load(std::memory_order_relaxed));
+			}
+			for (int other_partition_index = 0; other_partition_index < partition_count; other_partition_index ++) {
+				if (error_ticks[other_partition_index].load(std::memory_order_relaxed) < gvt) {
+					stop_flag = true;
+				}
+			}
+			if (partition_index == 0) {
+				gvt_request->store(0, std::memory_order_relaxed);
+			}
+			barrier_pointer->ArriveAndWait();
+			while ((snapshots.size() > 0) && (snapshots.front().tick_index < gvt)) {
+				spare_states.emplace_back(std::move(snapshots.front().state));
+				snapshots.pop_front();
+			}
+			for (int other_partition_index = 0; other_partition_index < partition_count; other_partition_index ++) {
+				received_messages[other_partition_index].erase(received_messages[other_partition_index].begin(), received_messages[other_partition_index].lower_bound(gvt));
+				sent_messages[other_partition_index].erase(sent_messages[other_partition_index].begin(), sent_messages[other_partition_index].lower_bound(gvt));
+			}
+			if (stop_flag || (gvt >= number_of_ticks)) {
+				// Errors from ticks the GVT has not passed may never have happened.
+				if (error_tick >= gvt) {
+					m_error_messages.clear();
+				}
+				break;
+			}
+			continue;
+		}
+		if ((local_tick >= std::min(number_of_ticks, gvt + optimistic_window)) || (error_tick != no_error_tick)) {
+			// Wait for the GVT to move on, only asking for it once the other partitions have got far enough for it to.
+			int earliest_live_tick = number_of_ticks;
+			for (int other_partition_index = 0; other_partition_index < partition_count; other_partition_index ++) {
+				earliest_live_tick = std::min(earliest_live_tick, live_ticks[other_partition_index].load(std::memory_order_relaxed));
+			}
+			if ((error_tick != no_error_tick) || (earliest_live_tick >= std::min(number_of_ticks, gvt + std::max(1, optimistic_window / 2)))) {
+				gvt_request->store(1, std::memory_order_release);
+			} else {
+				std::this_thread::yield();
+			}
+			continue;
+		}
+		// Run tick local_tick.
+		std::vector<unsigned char> state = {};
+		if (spare_states.size() > 0) {
+			state = std::move(spare_states.back());
+			spare_states.pop_back();
+			state.clear();
+		}
+		SavePartitionState(state);
+		snapshots.push_back({local_tick, std::move(state)});
+		for (const auto& this_clock_descriptor : m_clocks) {
+			this_clock_descriptor.clock_pointer->Tick();
+		}
+		// Every partition ticks every Clock, so Clock-driven in pin changes of remote Devices do not need sending.
+		for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+			if (m_remote_child_flags[local_component_index]) {
+				device_pointers[local_component_index]->CollectChangedInPins(boundary_pin_messages, local_tick);
+			}
+		}
+		boundary_pin_messages.clear();
+		Solve(false, m_CUID);
+		bool received_flag = false;
+		for (int source_index = 0; source_index < partition_count; source_index ++) {
+			auto this_tick_messages = received_messages[source_index].find(local_tick);
+			if ((source_index == partition_index) || (this_tick_messages == received_messages[source_index].end())) {
+				continue;
+			}
+			for (const auto& this_message : this_tick_messages->second) {
+				if (this_message.unknown) {
+					device_pointers[this_message.local_component_index]->SetUnknown(this_message.pin_port_index, this_message.state);
+				} else {
+					device_pointers[this_message.local_component_index]->Set(this_message.pin_port_index, this_message.state);
+				}
+				received_flag = true;
+			}
+		}
+		if (received_flag) {
+			Solve(false, m_CUID);
+		}
+		for (const auto& this_local_device_index : m_boundary_device_indices) {
+			device_pointers[this_local_device_index]->CollectChangedInPins(boundary_pin_messages, local_tick);
+		}
+		m_boundary_device_indices.clear();
+		for (const auto& this_message : boundary_pin_messages) {
+			tick_messages[device_partitions[this_message.local_component_index]].push_back(this_message);
+		}
+		boundary_pin_messages.clear();
+		for (int target_index = 0; target_index < partition_count; target_index ++) {
+			if (target_index == partition_index) {
+				continue;
+			}
+			std::vector<boundary_pin_message>& this_sent_messages = sent_messages[target_index][local_tick];
+			if (tick_messages[target_index] != this_sent_messages) {
+				outboxes[target_index].push_back({local_tick, 0, -1, false, false});
+				outboxes[target_index].insert(outboxes[target_index].end(), tick_messages[target_index].begin(), tick_messages[target_index].end());
+				this_sent_messages = tick_messages[target_index];
+			}
+			tick_messages[target_index].clear();
+		}
+		CheckProbeTriggers();
+		PrintAndClearMessages();
+		if (m_error_messages.size() > 0) {
+			error_tick = local_tick;
+		}
+		m_global_tick_index += 1;
+		local_tick += 1;
+		live_ticks[partition_index].store(local_tick, std::memory_order_relaxed);
+	}
+}
+
+void Simulation::SavePartitionState(std::vector<unsigned char>& state_buffer) {
+	// Everything a tick of RunPartitionOptimistically() can change - the whole of each top-level Device this partition
+	// owns, and the pins of the others (so that changes to them are seen again when a tick is run again).
+	int top_level_component_count = GetLocalComponentCount();
+	for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+		static_cast<Device*>(GetChildComponentPointer(local_component_index))->SaveState(state_buffer, !m_remote_child_flags[local_component_index]);
+	}
+}
+
+void Simulation::RestorePartitionState(std::vector<unsigned char> const& state_buffer) {
+	unsigned char const* state_pointer = state_buffer.data();
+	int top_level_component_count = GetLocalComponentCount();
+	for (int local_component_index = 0; local_component_index < top_level_component_count; local_component_index ++) {
+		state_pointer = static_cast<Device*>(GetChildComponentPointer(local_component_index))->RestoreState(state_pointer, !m_remote_child_flags[local_component_index]);
+	}
+}
+
 int Simulation::GetNewCUID() {
-	int new_CUID = m_next_new_CUID;
-	m_next_new_CUID ++;
-	return new_CUID;
+	// Components may be built on several threads at once, see Device::AddComponentsInParallel().
+	return m_next_new_CUID.fetch_add(1);
+}
+
+void Simulation::SetSeed(const uint64_t seed) {
+	// Random initial Gate in pin states are drawn from this Simulation's generator in build order, so building the
+	// same design with the same seed (set before adding any Components) gives the same starting state.
+	m_seed = seed;
+	m_random_generator.Seed(seed);
+}
+
+uint64_t Simulation::GetSeed() {
+	return m_seed;
+}
+
+bool Simulation::GetRandomBool() {
+	// Components built by Device::AddComponentsInParallel() draw from their slot's own stream.
+	if (mg_elaboration_slot != nullptr) {
+		return ((mg_elaboration_slot->random_generator.Next() >> 63) != 0);
+	}
+	return ((m_random_generator.Next() >> 63) != 0);
 }
 
 void Simulation::EnableTerminalRawIO(const bool raw_flag) {
 	// If raw_flag = true, we change some flags to set the current terminal to 'raw' mode, in which characters are
 	// immediately made available to STDIN, such that they can be read in using getchar(). If raw_flag = false, we
-	// change the flags back to their old value (captured in m_old_term_io_settings) to put the current terminal back
+	// change the flags back to their old value (captured in old_term_io_settings) to put the current terminal back
 	// in 'buffered' mode, where characters are buffered and only made available to STDIN after a newline character.
 	// Synthesised (along with the ioctl() call in CheckForCharacter() to actually check if a character is available
 	// before calling getchar()) from the example at https://www.flipcode.com/archives/_kbhit_for_Linux.shtml.
+	// The terminal belongs to the process rather than the Simulation, so when several Simulations Run() at once only
+	// the first to start captures the old settings and switches to raw mode, and only the last to finish restores them.
+	static std::mutex raw_io_lock;
+	static int raw_io_users = 0;
+	static termios old_term_io_settings;
+	std::unique_lock<std::mutex> lock(raw_io_lock);
 	int STDIN = 0;
 	if (raw_flag == true) {
-		termios new_term_io_settings;
-        tcgetattr(STDIN, &m_old_term_io_settings);
-        new_term_io_settings = m_old_term_io_settings;
-        new_term_io_settings.c_lflag &= (~ICANON & ~ECHO);
-        tcsetattr(STDIN, TCSANOW, &new_term_io_settings);
-        setbuf(stdin, NULL);
+		raw_io_users ++;
+		if (raw_io_users == 1) {
+			termios new_term_io_settings;
+			tcgetattr(STDIN, &old_term_io_settings);
+			new_term_io_settings = old_term_io_settings;
+			new_term_io_settings.c_lflag &= (~ICANON & ~ECHO);
+			tcsetattr(STDIN, TCSANOW, &new_term_io_settings);
+			setbuf(stdin, NULL);
+		}
 	} else {
-		tcsetattr(STDIN, TCSANOW, &m_old_term_io_settings);
+		raw_io_users --;
+		if (raw_io_users == 0) {
+			tcsetattr(STDIN, TCSANOW, &old_term_io_settings);
+		}
 	}
 }
 
@@ -108,9 +857,10 @@ char Simulation::CheckForCharacter() {
 
 void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output_flag, bool print_probes_flag, bool force_no_messages) {
 	bool print_errors_flag = false;
+	CollectLoggedMessages();
 	if (m_error_messages.size() == 0) {
-		bool previous_verbose_output_flag = mg_verbose_flag;
-		mg_verbose_flag = verbose_output_flag;
+		bool previous_verbose_output_flag = m_verbose_flag;
+		m_verbose_flag = verbose_output_flag;
 		m_simulation_running = true;
 		if (restart_flag) {
 			if (!force_no_messages) {
@@ -131,13 +881,14 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 		for (const auto& this_probe_descriptor : m_probes) {
 			this_probe_descriptor.probe_pointer->PreallocateSampleMemory(number_of_ticks);
 		}
-		if ((!mg_verbose_flag) && (!force_no_messages)) {
+		if ((!m_verbose_flag) && (!force_no_messages)) {
 			std::string message = std::string("\n(Simulation verbose output is off)");
 			std::cout << message << std::endl;
 		}
 		// Turn terminal to 'raw' mode (does not wait for newline before making input available to getchar()).
 		// ~~~ We need to manually set it back when we are done! ~~~
 		EnableTerminalRawIO(true);
+		StartPersistentWorkers();
 		int tick_count = 0;
 		int input_check_count = 0, input_check_count_limit = 1000;
 		// And we're live - Spin main simulation loop.
@@ -146,7 +897,7 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 			for (const auto& this_magic_engine_descriptor : m_magic_engines) {
 				this_magic_engine_descriptor.magic_engine_pointer->UpdateMagic();
 			}
-			if ((mg_verbose_flag) && (!force_no_messages)){
+			if ((m_verbose_flag) && (!force_no_messages)){
 				std::string message = GenerateHeader("Start of global tick " + std::to_string(m_global_tick_index));
 				LogMessage("\n" + message);
 			}
@@ -156,8 +907,11 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 			}
 			// Solve top-level simulation state.
 			Solve(false, m_CUID);
+			if (m_profiling_solve_costs) {
+				UpdateCostModel();
+			}
 			// Print any messages logged this tick.
-			//~if (mg_verbose_flag) {
+			//~if (m_verbose_flag) {
 				PrintAndClearMessages();
 			//~}
 			// If any errors have been reported this tick, break here and finish.
@@ -190,6 +944,7 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 				}
 			}
 		}
+		StopPersistentWorkers();
 		// Turn terminal back to 'buffered' mode (waits for newline before making input available to getchar()).
 		EnableTerminalRawIO(false);	
 		if (!force_no_messages) {
@@ -204,7 +959,7 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 			}
 			std::cout << GenerateHeader("Done.") << std::endl;
 		}
-		mg_verbose_flag = previous_verbose_output_flag;
+		m_verbose_flag = previous_verbose_output_flag;
 	} else {
 		print_errors_flag = true;
 	}
@@ -213,6 +968,68 @@ void Simulation::Run(int number_of_ticks, bool restart_flag, bool verbose_output
 	}
 }
 
+void Simulation::StartPersistentWorkers() {
+	// In persistent worker mode each pool worker (and this thread) owns a fixed partition of the child Devices of every
+	// threaded-solve Device for the whole Run(). Rather than queueing jobs every solve pass, SolvePendingChildDevices()
+	// and the workers meet at a spin barrier before and after each pass and each Solve()s the pending Devices of it's
+	// own partition. The workers occupy the thread pool until StopPersistentWorkers().
+	// With the cost model on, the workers are started once it has chosen the partitions, see UpdateCostModel().
+	if (!m_use_threaded_solver || !m_use_persistent_workers || m_profiling_solve_costs || m_persistent_workers_running) {
+		return;
+	}
+	int worker_count = m_thread_pool_pointer->GetWorkerCount();
+	if (worker_count < 1) {
+		return;
+	}
+	if (!m_use_cost_model) {
+		AssignSolvePartitions(worker_count + 1);
+	}
+	m_solve_barrier_pointer = new VoidSpinBarrier(worker_count + 1);
+	m_persistent_workers_running = true;
+	for (int partition_index = 0; partition_index < worker_count; partition_index ++) {
+		m_thread_pool_pointer->AddJob(m_persistent_worker_group, std::bind(&Simulation::PersistentWorkerLoop, this, partition_index));
+	}
+}
+
+void Simulation::StopPersistentWorkers() {
+	if (!m_persistent_workers_running) {
+		return;
+	}
+	// Release the workers from their pass start barrier with the running flag cleared.
+	m_persistent_workers_running = false;
+	m_solve_barrier_pointer->ArriveAndWait();
+	m_thread_pool_pointer->WaitForJobs(m_persistent_worker_group);
+	delete m_solve_barrier_pointer;
+	m_solve_barrier_pointer = 0;
+	m_partitioned_solve_device_pointer = 0;
+}
+
+void Simulation::PersistentWorkerLoop(const int partition_index) {
+	while (true) {
+		// Wait for SolvePendingChildDevices() to post a solve pass (or StopPersistentWorkers() to end the Run()).
+		m_solve_barrier_pointer->ArriveAndWait();
+		if (!m_persistent_workers_running) {
+			break;
+		}
+		m_partitioned_solve_device_pointer->SolvePartition(partition_index);
+		m_solve_barrier_pointer->ArriveAndWait();
+	}
+}
+
+void Simulation::UpdateCostModel() {
+	// For the first m_cost_model_warmup_ticks ticks of Run() everything is solved on this thread and every Device's
+	// Solve() time per tick is tracked. Then the cost model picks which Devices solve their children in parallel (at
+	// any depth) and balances those children across the workers and this thread. Nested parallel solves are not
+	// possible with persistent workers, as they serve one parallel Device at a time.
+	UpdateSolveCosts((m_cost_model_ticks_profiled == 0) ? 1.0 : m_solve_cost_smoothing);
+	m_cost_model_ticks_profiled ++;
+	if (m_cost_model_ticks_profiled >= m_cost_model_warmup_ticks) {
+		m_profiling_solve_costs = false;
+		ChooseParallelSubtrees(m_thread_pool_pointer->GetWorkerCount() + 1, !m_use_persistent_workers, m_min_parallel_gain);
+		StartPersistentWorkers();
+	}
+}
+
 void Simulation::AddClock(std::string const& clock_name, std::vector<bool> const& toggle_pattern, bool monitor_on) {
 	bool found = false;
 	for (const auto& this_clock_descriptor : m_clocks) {
@@ -292,7 +1109,7 @@ void Simulation::AddToMagicEngines(std::string const& magic_engine_identifier, M
 }
 
 int Simulation::GetTopLevelMaxPropagations() {
-	return m_max_propagations;
+	return m_configured_max_propagations;
 }
 
 Clock* Simulation::GetClockPointer(std::string const& target_clock_name) {
@@ -307,21 +1124,11 @@ Clock* Simulation::GetClockPointer(std::string const& target_clock_name) {
 }
 
 bool Simulation::IsSimulationRunning() {
-	if (!m_use_threaded_solver) {
-		return m_simulation_running;
-	} else {
-		std::unique_lock<std::mutex> lock(m_sim_lock);
-		return m_simulation_running;
-	}
+	return m_simulation_running.load(std::memory_order_acquire);
 }
 
 void Simulation::StopSimulation() {
-	if (!m_use_threaded_solver) {
-		m_simulation_running = false;
-	} else {
-		std::unique_lock<std::mutex> lock(m_sim_lock);
-		m_simulation_running = false;
-	}
+	m_simulation_running.store(false, std::memory_order_release);
 }
 
 void Simulation::CheckProbeTriggers() {
@@ -333,24 +1140,33 @@ void Simulation::CheckProbeTriggers() {
 }
 
 void Simulation::LogError(std::string const& error_message) {
-	if (!m_use_threaded_solver) {
+	if (mg_solve_event_buffer != nullptr) {
+		mg_solve_event_buffer->error_messages.emplace_back(error_message);
+	} else if (!m_use_threaded_solver) {
 		m_error_messages.emplace_back(error_message);
 	} else {
-		std::unique_lock<std::mutex> lock(m_sim_lock);
-		m_error_messages.emplace_back(error_message);
+		m_logged_error_messages.Push(error_message);
 	}
 }
 
 void Simulation::LogMessage(std::string const& message) {
-	if (!m_use_threaded_solver) {
+	if (mg_solve_event_buffer != nullptr) {
+		mg_solve_event_buffer->messages.emplace_back(message);
+	} else if (!m_use_threaded_solver) {
 		m_messages.emplace_back(message);
 	} else {
-		std::unique_lock<std::mutex> lock(m_sim_lock);
-		m_messages.emplace_back(message);
+		m_logged_messages.Push(message);
 	}
 }
 
+void Simulation::CollectLoggedMessages() {
+	// Move anything logged via the lock-free queues (threaded mode) onto the end of the message and error lists.
+	m_logged_messages.Drain([this](std::string& message) { m_messages.emplace_back(std::move(message)); });
+	m_logged_error_messages.Drain([this](std::string& error_message) { m_error_messages.emplace_back(std::move(error_message)); });
+}
+
 void Simulation::PrintAndClearMessages() {
+	CollectLoggedMessages();
 	std::unordered_map<int, std::vector<std::string>> message_collations;
 	for (auto& this_message : m_messages) {
 		std::string start_prefix = std::string("~S");	// Solution branch start.
@@ -393,6 +1209,7 @@ void Simulation::PrintAndClearMessages() {
 }
 
 void Simulation::PrintErrorMessages(void) {
+	CollectLoggedMessages();
 	if (m_error_messages.size() > 0) {
 		std::cout << std::endl << GenerateHeader("Error messages.") << std::endl << std::endl;
 		int index = 0;
@@ -424,7 +1241,7 @@ std::vector<std::vector<std::vector<bool>>> Simulation::GetProbedStates(std::vec
 
 void Simulation::PurgeComponent() {
 	std::string header;
-	if (mg_verbose_destructor_flag) {
+	if (m_verbose_destructor_flag) {
 		header =  "Purging -> SIMULATION : " + m_full_name + " @ " + PointerToString(static_cast<void*>(this));
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -444,7 +1261,7 @@ void Simulation::PurgeComponent() {
 			delete this_probe_descriptor.probe_pointer;
 		}
 	}
-	if (mg_verbose_destructor_flag) {
+	if (m_verbose_destructor_flag) {
 		header =  "SIMULATION : " + m_full_name + " @ " + PointerToString(static_cast<void*>(this)) + " -> Purged.";
 		std::cout << GenerateHeader(header) << std::endl;
 	}
@@ -497,8 +1314,8 @@ void Simulation::PurgeProbeDescriptorFromSimulation(Probe* target_probe_pointer)
 			new_probe_descriptor.probe_pointer = this_probe_descriptor.probe_pointer;
 			new_probes.push_back(new_probe_descriptor);
 		} else {
-			if (mg_verbose_destructor_flag) {
-				std::cout << "Purging " << this_probe_descriptor.probe_name << " from Simulation " << m_name << " m_probes." << std::endl;
+			if (m_verbose_destructor_flag) {
+				std::cout << "Purging " << this_probe_descriptor.probe_name << " from Simulation " << *m_name << " m_probes." << std::endl;
 			}
 		}
 	}
@@ -531,8 +1348,8 @@ void Simulation::PurgeClockDescriptorFromSimulation(Clock* target_clock_pointer)
 			new_clock_descriptor.clock_pointer = this_clock_descriptor.clock_pointer;
 			new_clocks.push_back(new_clock_descriptor);
 		} else {
-			if (mg_verbose_destructor_flag) {
-				std::cout << "Purging " << this_clock_descriptor.clock_name << " from Simulation " << m_name << " m_clocks." << std::endl;
+			if (m_verbose_destructor_flag) {
+				std::cout << "Purging " << this_clock_descriptor.clock_name << " from Simulation " << *m_name << " m_clocks." << std::endl;
 			}
 		}
 	}
@@ -548,8 +1365,8 @@ void Simulation::PurgeMagicEngineDescriptorFromSimulation(magic_engine_descripto
 			new_magic_engine_descriptor.magic_engine_pointer = this_magic_engine_descriptor.magic_engine_pointer;
 			new_magic_engines.push_back(new_magic_engine_descriptor);
 		} else {
-			if (mg_verbose_destructor_flag) {
-				std::cout << "Purging " << this_magic_engine_descriptor.magic_engine_identifier << " from Simulation " << m_name << " m_magic_engines." << std::endl;
+			if (m_verbose_destructor_flag) {
+				std::cout << "Purging " << this_magic_engine_descriptor.magic_engine_identifier << " from Simulation " << *m_name << " m_magic_engines." << std::endl;
 			}
 		}
 	}
@@ -560,12 +1377,22 @@ void Simulation::PurgeGlobalComponent(std::string const& target_component_full_n
 	Component* target_component_pointer = 0;
 	target_component_pointer = m_top_level_sim_pointer->SearchForComponentPointer(target_component_full_name);
 	if (target_component_pointer != 0) {
-		delete target_component_pointer;
+		DeleteComponent(target_component_pointer);
 	} else {
 		std::cout << "Global Component " << target_component_full_name << " not found." << std::endl;
 	}
 }
 
+void Simulation::RemapComponentPointers(std::unordered_map<Component*, Component*> const& pointer_map) {
+	// Update any Clock connections or Probe targets that point at relocated Components.
+	for (const auto& this_clock_descriptor : m_clocks) {
+		this_clock_descriptor.clock_pointer->RemapConnections(pointer_map);
+	}
+	for (const auto& this_probe_descriptor : m_probes) {
+		this_probe_descriptor.probe_pointer->RemapTargetComponentPointer(pointer_map);
+	}
+}
+
 bool Simulation::GetSearchingFlag() {
 	return m_searching_flag;
 }
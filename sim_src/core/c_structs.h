@@ -26,6 +26,7 @@
 // Includes for this header.
 #include <string>					// std::string.
 #include <vector>					// std::vector
+#include <cstdint>					// uint64_t
 
 // Forward declarations for struct definitions below.
 class Component;
@@ -38,17 +39,17 @@ class MagicEngine;
 
 // Define data structures.
 struct pin {
-	std::string name;
+	std::string const* name;		// Shared name, see Component::GetSharedName().
 	int direction;
 	bool state;
 	bool state_changed;
 	int port_index;
-	std::vector<bool> drive;
+	bool drive[2];
+	bool unknown;					// With state: F/F = 0, T/F = 1, F/T = X (unknown), T/T = Z (high impedance).
 };
 
 struct component_descriptor {
-	std::string component_name;
-	std::string component_full_name;
+	std::string const* component_name;		// Shared name, see Component::GetSharedName().
 	Component* component_pointer;
 };
 
@@ -57,9 +58,129 @@ struct state_descriptor {
 	bool state;
 };
 
+// Gate logical operators, used to group Gates for batched evaluation (see Device::EvaluateDeferredGates()).
+enum gate_operator {
+	GATE_AND = 0,
+	GATE_NAND,
+	GATE_OR,
+	GATE_NOR,
+	GATE_NOT,
+	GATE_OPERATOR_COUNT
+};
+
+// Packed in pin states of Gates with the same operator, evaluated together by Gate::EvaluateGateBatch().
+// Results are two-bit logic values, see Gate::EvaluateOperator().
+struct gate_batch {
+	std::vector<uint64_t> in_pin_words;
+	std::vector<uint64_t> in_pin_unknown_words;
+	std::vector<uint64_t> in_pin_masks;
+	std::vector<int> deferred_indices;
+	std::vector<unsigned char> results;
+};
+
+// Logging policies for the solver core. The inner loops of the solver are instantiated once per policy, and the
+// quiet instantiation (used when nothing is verbose or monitored, see Simulation::UseVerboseLogging()) contains no
+// logging checks or message building at all.
+struct quiet_logging {
+	static constexpr bool enabled = false;
+};
+
+struct verbose_logging {
+	static constexpr bool enabled = true;
+};
+
+// Messages and errors logged while a child Device is solved in parallel with it's siblings. Each Device solved in
+// parallel has it's own buffer, and the parent merges them in queue order after the join, see Simulation::LogMessage().
+struct solve_event_buffer {
+	std::vector<std::string> messages;
+	std::vector<std::string> error_messages;
+};
+
+// xoshiro256** pseudo-random number generator (Blackman & Vigna). Each Simulation has it's own, so initial states
+// can be replayed from a seed and Simulations built concurrently do not share a generator, see Simulation::SetSeed().
+struct xoshiro256_generator {
+	uint64_t state[4];
+	
+	void Seed(uint64_t seed) {
+		// Expand the seed into the four words of state with SplitMix64, as recommended by the authors.
+		for (auto& this_word : state) {
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t mixed = seed;
+			mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+			this_word = mixed ^ (mixed >> 31);
+		}
+	}
+	uint64_t Next(void) {
+		uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+		uint64_t shifted = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = RotateLeft(state[3], 45);
+		return result;
+	}
+	static uint64_t RotateLeft(const uint64_t value, const int count) {
+		return (value << count) | (value >> (64 - count));
+	}
+};
+
+// A child Component being built on a worker thread by Device::AddComponentsInParallel(). The local component index is
+// reserved by the parent beforehand, and everything built on the slot draws initial states from the slot's own random
+// stream and logs into the slot's own event buffer, so the result does not depend on which thread built what.
+struct elaboration_slot {
+	Device* parent_device_pointer;			// Cleared once the child has claimed it's index, see Device::GetNewLocalComponentIndex().
+	int local_component_index;
+	Component* component_pointer;
+	xoshiro256_generator random_generator;
+	solve_event_buffer events;
+};
+
+// Usually brace-initialised by position, so new fields are only ever added at the end.
 struct solver_configuration {
 	bool use_threaded_solver;
 	int threaded_solve_nesting_level;
+	bool use_unknown_states = false;			// Start Gate inputs and undefaulted Device pins as X instead of random/false.
+	bool use_persistent_workers = false;		// Threaded solver only - each worker solves a fixed partition of child Devices for
+												// the whole of Run(), see Simulation::StartPersistentWorkers().
+	bool use_cost_model = false;				// Threaded solver only - ignore threaded_solve_nesting_level and choose which Devices
+												// solve their children in parallel from measured Solve() costs, see
+												// Simulation::UpdateCostModel().
+	bool use_parallel_build = false;			// Build and Stabilise() sibling Devices on the thread pool, see
+												// Device::AddComponentsInParallel().
+	uint64_t seed = 0;							// Seed for randomised initial states, 0 to seed from the time (see Simulation::GetSeed()).
+	double min_offload_work = 128.0;			// Threaded solver only - child Devices expected to propagate fewer Components than this
+												// are solved inline rather than by a worker, see Device::EstimateSolveWork().
+	double min_parallel_gain = 50000.0;			// Cost model only - ns of child Solve() time per tick that must overlap the largest
+												// child for them to be solved in parallel, see Device::ChooseParallelSubtrees().
+};
+
+// What one branch of Simulation::Branch() passed back to the parent process.
+struct branch_result {
+	bool completed_flag;
+	std::vector<std::vector<std::vector<bool>>> probed_states;		// As returned by Simulation::GetProbedStates().
+};
+
+// An in pin change of a top-level Device owned by another process of Simulation::RunPartitioned(). In optimistic mode
+// a message with a pin_port_index of -1 starts the list of changes sent for it's tick, replacing any sent before.
+struct boundary_pin_message {
+	bool operator==(boundary_pin_message const& rhs) const {
+		return ((this->tick_index == rhs.tick_index) && (this->local_component_index == rhs.local_component_index) &&
+				(this->pin_port_index == rhs.pin_port_index) && (this->state == rhs.state) && (this->unknown == rhs.unknown));
+	}
+	int tick_index;
+	int local_component_index;
+	int pin_port_index;
+	bool state;
+	bool unknown;
+};
+
+// State of one process of an optimistic Simulation::RunPartitioned(), saved at the start of a tick.
+struct partition_snapshot {
+	int tick_index;
+	std::vector<unsigned char> state;		// See Device::SaveState().
 };
 
 struct probe_configuration {
@@ -73,6 +194,23 @@ struct connection_descriptor {
 	int target_pin_port_index;
 };
 
+struct gate_connection_descriptor {
+	Gate* target_gate_pointer;
+	int target_pin_port_index;
+};
+
+struct device_connection_descriptor {
+	Device* target_device_pointer;
+	int target_pin_port_index;
+};
+
+// Run-time copy of a list of connection_descriptors, split by target type so that they can be Set() without a virtual call.
+// Rebuilt from the connection_descriptors whenever they change, see Component::BuildFanout().
+struct fanout_descriptor {
+	std::vector<gate_connection_descriptor> gate_targets;
+	std::vector<device_connection_descriptor> device_targets;
+};
+
 struct clock_descriptor {
 	std::string clock_name;
 	Clock* clock_pointer;
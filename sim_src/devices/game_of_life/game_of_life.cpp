@@ -22,6 +22,7 @@
 #include <string>					// std::string.
 #include <iostream>					// std::cout, std::endl.
 #include <vector>					// std::vector
+#include <functional>				// std::function
 
 #include "c_core.h"					// Core simulator functionality
 #include "devices.h"
@@ -209,12 +210,25 @@ void GameOfLife::ConfigureBusses(std::vector<state_descriptor> in_pin_default_st
 }
 
 void GameOfLife::Build() {
-	// Instantiate cells and make main connections from game of life inputs and to outputs.
+	// Instantiate cells (independently, so they can be built in parallel) and then make main connections from game of
+	// life inputs and to outputs.
+	std::vector<std::function<Component*()>> cell_builders;
+	for (int cell_index = 0; cell_index < m_cell_count; cell_index ++) {
+		std::string cell_identifier = "cell_" + std::to_string(cell_index);
+		cell_builders.push_back([this, cell_identifier]() {
+			return new GameOfLife_Cell(this, cell_identifier, false, {{"not_clear_cycle", true}, {"not_clear_state", true}, {"not_preset_state", true}});
+		});
+	}
+	if (!AddComponentsInParallel(cell_builders)) {
+		// Some cells were not built, so the grid can not be wired up.
+		std::string build_error = "Device " + m_full_name + " could not build all " + std::to_string(m_cell_count) + " cells, so is left unconnected.";
+		m_top_level_sim_pointer->LogError(build_error);
+		return;
+	}
 	int current_cell_id = 0;
 	for (int row_index = 0; row_index < m_x_dimension; row_index ++) {
 		for (int column_index = 0; column_index < m_x_dimension; column_index ++) {
 			std::string cell_identifier = "cell_" + std::to_string(current_cell_id);
-			AddComponent(new GameOfLife_Cell(this, cell_identifier, false, {{"not_clear_cycle", true}, {"not_clear_state", true}, {"not_preset_state", true}}));
 			Connect("clk", cell_identifier, "clk");
 			Connect(cell_identifier + "_not_clear_state", cell_identifier, "not_clear_state");
 			Connect(cell_identifier + "_not_preset_state", cell_identifier, "not_preset_state");
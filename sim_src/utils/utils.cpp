@@ -25,6 +25,8 @@
 #include <unordered_map>			// std::unordered_map
 #include <iostream>					// std::cout, std::endl.
 #include <cmath>
+#include <algorithm>				// std::stable_sort
+#include <cstring>					// std::memcpy
 
 #include "c_core.h"					// Core simulator functionality
 #include "utils.h"
@@ -113,6 +115,51 @@ char BoolToChar(bool logical_state) {
 	} 
 }
 
+char LogicToChar(bool logical_state, bool unknown) {
+	if (unknown) {
+		if (logical_state) {
+			return 'Z';
+		} else {
+			return 'X';
+		}
+	} else {
+		return BoolToChar(logical_state);
+	}
+}
+
+uint64_t MixHash(uint64_t value) {
+	// 64-bit finaliser from SplitMix64 - every input bit affects every output bit.
+	value ^= (value >> 30);
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= (value >> 27);
+	value *= 0x94d049bb133111ebULL;
+	value ^= (value >> 31);
+	return value;
+}
+
+std::vector<int> PartitionByCost(std::vector<double> const& costs, const int partition_count) {
+	// Longest-processing-time-first - place items in decreasing order of cost, each into the currently least loaded
+	// partition. Returns the partition index of each item. Ties keep the original item order, so the result is stable.
+	std::vector<int> item_order(costs.size());
+	for (size_t i = 0; i < item_order.size(); i ++) {
+		item_order[i] = i;
+	}
+	std::stable_sort(item_order.begin(), item_order.end(), [&costs](int a, int b) { return costs[a] > costs[b]; });
+	std::vector<double> partition_loads(partition_count, 0.0);
+	std::vector<int> item_partitions(costs.size(), 0);
+	for (const auto& this_item_index : item_order) {
+		int least_loaded_partition = 0;
+		for (int partition_index = 1; partition_index < partition_count; partition_index ++) {
+			if (partition_loads[partition_index] < partition_loads[least_loaded_partition]) {
+				least_loaded_partition = partition_index;
+			}
+		}
+		item_partitions[this_item_index] = least_loaded_partition;
+		partition_loads[least_loaded_partition] += costs[this_item_index];
+	}
+	return item_partitions;
+}
+
 std::string GenerateHeader(std::string header_message) {
 	std::string header = "\x1B[1m";
 	int message_length = header_message.size();
@@ -139,6 +186,55 @@ std::string GenerateHeader(std::string header_message) {
 	return header; 
 }
 
+size_t PackProbedStates(std::vector<std::vector<std::vector<bool>>> const& probed_states, unsigned char* destination, const size_t capacity) {
+	// Flatten Probe samples (as returned by Simulation::GetProbedStates()) into a byte buffer - a 32-bit count before
+	// each level and one byte per state. Returns the packed size, only writing to the destination if it fits.
+	size_t packed_size = 0;
+	auto pack_count = [&](uint32_t count) {
+		if ((packed_size + sizeof(count)) <= capacity) {
+			std::memcpy(destination + packed_size, &count, sizeof(count));
+		}
+		packed_size += sizeof(count);
+	};
+	pack_count(probed_states.size());
+	for (const auto& this_probe_samples : probed_states) {
+		pack_count(this_probe_samples.size());
+		for (const auto& this_sample : this_probe_samples) {
+			pack_count(this_sample.size());
+			for (const auto& this_state : this_sample) {
+				if (packed_size < capacity) {
+					destination[packed_size] = this_state;
+				}
+				packed_size ++;
+			}
+		}
+	}
+	return packed_size;
+}
+
+std::vector<std::vector<std::vector<bool>>> UnpackProbedStates(unsigned char const* source) {
+	// Inverse of PackProbedStates().
+	size_t unpacked_size = 0;
+	auto unpack_count = [&]() {
+		uint32_t count;
+		std::memcpy(&count, source + unpacked_size, sizeof(count));
+		unpacked_size += sizeof(count);
+		return count;
+	};
+	std::vector<std::vector<std::vector<bool>>> probed_states(unpack_count());
+	for (auto& this_probe_samples : probed_states) {
+		this_probe_samples.resize(unpack_count());
+		for (auto& this_sample : this_probe_samples) {
+			this_sample.resize(unpack_count());
+			for (size_t i = 0; i < this_sample.size(); i ++) {
+				this_sample[i] = (source[unpacked_size] != 0);
+				unpacked_size ++;
+			}
+		}
+	}
+	return probed_states;
+}
+
 std::string PointerToString(void* pointer){
 	std::stringstream ss;
 	ss << pointer;
@@ -35,6 +35,11 @@ void StaggerPrint(int level, int width);
 void StaggerPrint(int width);
 std::string GenerateHeader(std::string header_message);
 char BoolToChar(bool logical_state);
+char LogicToChar(bool logical_state, bool unknown);
+uint64_t MixHash(uint64_t value);
+std::vector<int> PartitionByCost(std::vector<double> const& costs, const int partition_count);
+size_t PackProbedStates(std::vector<std::vector<std::vector<bool>>> const& probed_states, unsigned char* destination, const size_t capacity);
+std::vector<std::vector<std::vector<bool>>> UnpackProbedStates(unsigned char const* source);
 std::string PointerToString(void* pointer);
 std::vector<bool> IsStringInStateDescriptorVector(std::string const& string_to_find, std::vector<state_descriptor> state_descriptor_vector_to_search);
 
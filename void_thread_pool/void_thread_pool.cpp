@@ -1,6 +1,6 @@
 /*
 	
-	void_thread_pool.cpp - An ultra-simple thread pool implementation for running void() functions in multiple worker threads.
+	void_thread_pool.cpp - An ultra-simple work-stealing thread pool implementation for running void() functions in multiple worker threads.
 	
 	Copyright © 2021 Dr Seb N.F. Sikora.
 	
@@ -30,14 +30,23 @@
 
 #include <vector>						// std::vector.
 #include <iostream>						// std::cout, std::endl.
-#include <thread>						// std::thread.
+#include <thread>						// std::thread, std::this_thread::yield.
 #include <mutex>						// std::mutex, std::unique_lock.
 #include <condition_variable>			// std::condition_variable.
-#include <queue>						// std::queue.
+#include <deque>						// std::deque.
+#include <memory>						// std::unique_ptr.
+#include <atomic>						// std::atomic.
 #include <functional>					// std::function.
 
 #include "void_thread_pool.hpp"
 
+// The pool (if any) that the calling thread is a worker of, and it's worker id within that pool.
+static thread_local VoidThreadPool const* t_worker_pool = nullptr;
+static thread_local int t_worker_id = -1;
+
+// How many times an idle worker looks for something to steal before parking on the idle condition variable.
+static const int k_idle_spin_count = 64;
+
 VoidThreadPool::VoidThreadPool(bool display_messages, int number_of_workers) {
 	m_display_messages = display_messages;
 	int num_threads;
@@ -49,6 +58,11 @@ VoidThreadPool::VoidThreadPool(bool display_messages, int number_of_workers) {
 	if (m_display_messages) {
 		std::cout << "Void ThreadPool starting " << num_threads << " worker threads..." << std::endl;
 	}
+	// One queue per worker, plus one for jobs added from outside the pool. All of them must exist before any worker starts.
+	for (int i = 0; i <= num_threads; i ++) {
+		m_worker_queues.push_back(std::make_unique<worker_queue>());
+	}
+	m_external_queue_index = num_threads;
 	for (int i = 0; i < num_threads; i ++) {
 		// Pass worker member function by reference to avoid the thread making it's own copy.
 		m_threads.push_back(std::thread(&VoidThreadPool::WorkerFunction, this, i));
@@ -62,84 +76,146 @@ VoidThreadPool::~VoidThreadPool() {
 }
 
 void VoidThreadPool::WorkerFunction(int worker_id) {
+	t_worker_pool = this;
+	t_worker_id = worker_id;
 	if (m_display_messages) {
 		// Pre-composing our whole message stops messages from one thread being interrupted by messages from another thread.
 		std::string message = "Worker function " + std::to_string(worker_id) + " starting.\n";
 		std::cout << message;
 	}
-	std::function<void()> job;
 	while (true) {
+		if (RunQueuedJob(worker_id)) {
+			continue;
+		}
+		// Nothing to run or steal. Jobs tend to arrive in bursts, so spin for a short while before parking.
+		for (int spin = 0; (spin < k_idle_spin_count) && (m_jobs_queued.load() <= 0) && !m_finish.load(); spin ++) {
+			std::this_thread::yield();
+		}
+		if (m_jobs_queued.load() > 0) {
+			continue;
+		}
 		{
-			std::unique_lock<std::mutex> lock(m_queue_lock);
-			// See below for explanation of the syntax [this]() { ... } for the predicate second argument to condition_variable.wait().
-			// https://stackoverflow.com/questions/39565218/c-condition-variable-wait-for-predicate-in-my-class-stdthread-unresolved-o
-			m_queue_condition.wait(lock, [this]() { return !m_job_queue.empty() || m_finish; });
-			
-			if (m_finish && m_job_queue.empty()) {
-				if (m_display_messages) {
-					std::string message = "Worker function " + std::to_string(worker_id) + " stoppped.\n";
-					std::cout << message;
-				}
-				return;
-			} else {
-				job = m_job_queue.front();
-				m_job_queue.pop();
+			std::unique_lock<std::mutex> lock(m_idle_lock);
+			// AddJob() only notifies when it sees an idle worker, so we must count ourselves as idle before checking
+			// for queued jobs in the predicate, otherwise a job added in between would be missed.
+			m_workers_idle ++;
+			m_idle_condition.wait(lock, [this]() { return (m_jobs_queued.load() > 0) || m_finish.load(); });
+			m_workers_idle --;
+		}
+		if (m_finish.load() && (m_jobs_queued.load() <= 0)) {
+			if (m_display_messages) {
+				std::string message = "Worker function " + std::to_string(worker_id) + " stoppped.\n";
+				std::cout << message;
 			}
+			return;
 		}
-		job();
-		{
-			// Once the current job has finished, decrement the pending job counter.
-			// If there are no pending jobs and we are waiting, alert the waiting function via condition variable.
-			std::unique_lock<std::mutex> lock(m_counter_lock);
-			m_jobs_pending --;
-			if ((m_jobs_pending == 0) && (m_waiting_for_completion)) {
-				m_counter_condition.notify_one();
+	}
+}
+
+int VoidThreadPool::GetOwnQueueIndex(void) {
+	if (t_worker_pool == this) {
+		return t_worker_id;
+	} else {
+		return m_external_queue_index;
+	}
+}
+
+bool VoidThreadPool::RunQueuedJob(const int own_queue_index) {
+	if (m_jobs_queued.load() <= 0) {
+		return false;
+	}
+	queued_job next_job;
+	bool job_found = false;
+	{
+		// Newest job from our own queue first...
+		worker_queue& own_queue = *m_worker_queues[own_queue_index];
+		std::unique_lock<std::mutex> lock(own_queue.lock);
+		if (!own_queue.jobs.empty()) {
+			next_job = std::move(own_queue.jobs.back());
+			own_queue.jobs.pop_back();
+			job_found = true;
+		}
+	}
+	if (!job_found) {
+		// ...otherwise steal the oldest job from another queue, starting with our neighbour so thieves spread out.
+		int queue_count = m_worker_queues.size();
+		for (int offset = 1; offset < queue_count; offset ++) {
+			worker_queue& victim_queue = *m_worker_queues[(own_queue_index + offset) % queue_count];
+			std::unique_lock<std::mutex> lock(victim_queue.lock);
+			if (!victim_queue.jobs.empty()) {
+				next_job = std::move(victim_queue.jobs.front());
+				victim_queue.jobs.pop_front();
+				job_found = true;
+				break;
 			}
 		}
 	}
+	if (!job_found) {
+		return false;
+	}
+	m_jobs_queued --;
+	next_job.job();
+	// Release ordering so that everything the job wrote is visible to whoever sees the group complete.
+	next_job.group->jobs_pending.fetch_sub(1, std::memory_order_release);
+	return true;
 }
 
 void VoidThreadPool::AddJob(std::function<void()> new_job) {
-	// Increment the pending job counter and push the new job onto the queue.
+	AddJob(m_default_group, std::move(new_job));
+}
+
+void VoidThreadPool::AddJob(void_job_group& group, std::function<void()> new_job) {
+	// Jobs added by a worker (ie - from inside another job) go on it's own queue, everything else on the external queue.
+	group.jobs_pending.fetch_add(1, std::memory_order_relaxed);
 	{
-		std::unique_lock<std::mutex> lock(m_counter_lock);
-		m_jobs_pending ++;
+		worker_queue& own_queue = *m_worker_queues[GetOwnQueueIndex()];
+		std::unique_lock<std::mutex> lock(own_queue.lock);
+		own_queue.jobs.push_back({std::move(new_job), &group});
 	}
-	{
-		std::unique_lock<std::mutex> lock(m_queue_lock);
-		m_job_queue.push(new_job);
+	m_jobs_queued ++;
+	// Only wake a parked worker if there is one, taking the idle lock so the notification cannot slip in between it's
+	// predicate check and it's wait.
+	if (m_workers_idle.load() > 0) {
+		{
+			std::unique_lock<std::mutex> lock(m_idle_lock);
+		}
+		m_idle_condition.notify_one();
 	}
-	// Notify one worker function that there is now a pending job.
-	m_queue_condition.notify_one();
 }
 
 void VoidThreadPool::WaitForAllJobs(void) {
-	while (true) {		// Wrap the wait on m_job_counter_condition in a while loop in case the condition wakes up spuriously.
-		{
-			std::unique_lock<std::mutex> lock(m_counter_lock);
-			if (m_jobs_pending > 0) {
-				if (m_display_messages) {
-					std::string message = "*** Waiting for all jobs to complete...\n";
-					std::cout << message;
-				}
-				m_waiting_for_completion = true;
-				m_counter_condition.wait(lock, [this]() { return m_jobs_pending == 0; });
-				if (m_jobs_pending == 0) {
-					m_waiting_for_completion = false;
-					if (m_display_messages) {
-						std::cout << "...all jobs completed. ***" << std::endl;
-					}
-					break;
-				}
-			} else {
-				if (m_display_messages) {
-					std::string message = "No uncompleted jobs.\n";
-					std::cout << message;
-				}
-				break;
-			}
+	WaitForJobs(m_default_group);
+}
+
+void VoidThreadPool::WaitForJobs(void_job_group& group) {
+	// Rather than blocking, the waiting thread runs (or steals) queued jobs until the group completes. This means a job
+	// can itself add jobs and wait on them without tying up a worker, and the waiting thread contributes to the work.
+	if (group.jobs_pending.load(std::memory_order_acquire) == 0) {
+		if (m_display_messages) {
+			std::string message = "No uncompleted jobs.\n";
+			std::cout << message;
+		}
+		return;
+	}
+	if (m_display_messages) {
+		std::string message = "*** Waiting for all jobs to complete...\n";
+		std::cout << message;
+	}
+	int own_queue_index = GetOwnQueueIndex();
+	while (group.jobs_pending.load(std::memory_order_acquire) > 0) {
+		if (!RunQueuedJob(own_queue_index)) {
+			// Remaining jobs of this group are running elsewhere.
+			std::this_thread::yield();
 		}
 	}
+	if (m_display_messages) {
+		std::string message = "...all jobs completed. ***\n";
+		std::cout << message;
+	}
+}
+
+int VoidThreadPool::GetWorkerCount(void) {
+	return m_threads.size();
 }
 
 void VoidThreadPool::Finish(void) {
@@ -147,12 +223,12 @@ void VoidThreadPool::Finish(void) {
 		std::string shutdown_message = "Finish() called...\n"; 
 		std::cout << shutdown_message;
 	}
-	// Set the stop flag and notify all processes.
+	// Set the stop flag and notify all workers. Workers carry on until all queued jobs are completed.
 	{
-		std::unique_lock<std::mutex> lock(m_queue_lock);
+		std::unique_lock<std::mutex> lock(m_idle_lock);
 		m_finish = true;
 	}
-	m_queue_condition.notify_all();
+	m_idle_condition.notify_all();
 	// Wait and join all threads.
 	for (std::thread& thread : m_threads) {
 		thread.join();
@@ -163,3 +239,51 @@ void VoidThreadPool::Finish(void) {
 		std::cout << "...all worker threads are stopped." << std::endl;
 	}
 }
+
+VoidSpinBarrier::VoidSpinBarrier(int participant_count, int spin_count) {
+	m_participant_count = participant_count;
+	m_spin_count = spin_count;
+}
+
+void VoidSpinBarrier::ArriveAndWait(void) {
+	unsigned int generation = m_generation.load(std::memory_order_acquire);
+	if (m_arrived.fetch_add(1, std::memory_order_acq_rel) == (m_participant_count - 1)) {
+		// Last to arrive - reset the count for the next meeting before releasing everyone.
+		m_arrived.store(0, std::memory_order_relaxed);
+		m_generation ++;
+		if (m_parked.load() > 0) {
+			{
+				std::unique_lock<std::mutex> lock(m_park_lock);
+			}
+			m_park_condition.notify_all();
+		}
+		return;
+	}
+	for (int spin = 0; spin < m_spin_count; spin ++) {
+		if (m_generation.load(std::memory_order_acquire) != generation) {
+			return;
+		}
+		std::this_thread::yield();
+	}
+	std::unique_lock<std::mutex> lock(m_park_lock);
+	// As for idle pool workers, count ourselves as parked before the predicate check so the release cannot be missed.
+	m_parked ++;
+	m_park_condition.wait(lock, [this, generation]() { return m_generation.load(std::memory_order_acquire) != generation; });
+	m_parked --;
+}
+
+VoidSharedSpinBarrier::VoidSharedSpinBarrier(int participant_count) {
+	m_participant_count = participant_count;
+}
+
+void VoidSharedSpinBarrier::ArriveAndWait(void) {
+	unsigned int generation = m_generation.load(std::memory_order_acquire);
+	if (m_arrived.fetch_add(1, std::memory_order_acq_rel) == (m_participant_count - 1)) {
+		m_arrived.store(0, std::memory_order_relaxed);
+		m_generation ++;
+		return;
+	}
+	while (m_generation.load(std::memory_order_acquire) == generation) {
+		std::this_thread::yield();
+	}
+}
@@ -35,32 +35,182 @@
 #include <thread>						// std::thread.
 #include <mutex>						// std::mutex, std::unique_lock.
 #include <condition_variable>			// std::condition_variable.
-#include <queue>						// std::queue.
+#include <deque>						// std::deque.
+#include <memory>						// std::unique_ptr.
+#include <atomic>						// std::atomic.
+#include <cstdint>						// uint64_t.
+#include <new>							// placement new.
 #include <functional>					// std::function.
 
+// A set of jobs that can be waited on together via VoidThreadPool::WaitForJobs(). Jobs in a group may themselves add
+// jobs to (and wait on) other groups, so fork-join parallelism can be nested to any depth.
+struct void_job_group {
+	std::atomic<int> jobs_pending{0};
+};
+
 class VoidThreadPool {
 	private:
+		struct queued_job {
+			std::function<void()> job;
+			void_job_group* group;
+		};
+		// Each worker owns a double-ended queue. The owner pushes and pops at the back (most recently added first, which
+		// keeps nested jobs hot in cache), idle workers steal from the front of the others. There is one extra queue for
+		// jobs added from threads outside the pool.
+		struct worker_queue {
+			std::mutex lock;
+			std::deque<queued_job> jobs;
+		};
 		bool m_display_messages = false;
 		std::vector<std::thread> m_threads = {};
 		bool m_pool_stopped = false;
-		// Synchronisation of job queue and stop flag.
-		std::condition_variable m_queue_condition;
-		std::mutex m_queue_lock;
-		std::queue<std::function<void()>> m_job_queue = {};
-		bool m_finish = false;
-		// Synchronisation of pending job counter and waiting flag.
-		std::condition_variable m_counter_condition;
-		std::mutex m_counter_lock;
-		int m_jobs_pending = 0;
-		bool m_waiting_for_completion = false;
+		std::vector<std::unique_ptr<worker_queue>> m_worker_queues = {};
+		int m_external_queue_index = 0;
+		void_job_group m_default_group;
+		// Idle workers park here until there is something to steal or the pool is finishing.
+		std::condition_variable m_idle_condition;
+		std::mutex m_idle_lock;
+		std::atomic<int> m_jobs_queued{0};
+		std::atomic<int> m_workers_idle{0};
+		std::atomic<bool> m_finish{false};
+		
+		int GetOwnQueueIndex(void);
+		bool RunQueuedJob(const int own_queue_index);
 		
 	public:
 		VoidThreadPool(bool display_messages = false, int number_of_workers = 0);
 		~VoidThreadPool();
 		void WorkerFunction(int worker_id);
 		void AddJob(std::function<void()> new_job);
+		void AddJob(void_job_group& group, std::function<void()> new_job);
 		void WaitForAllJobs(void);
+		void WaitForJobs(void_job_group& group);
+		int GetWorkerCount(void);
 		void Finish(void);
 };
 
+// Unbounded lock-free multiple-producer single-consumer queue. Any thread may Push(), a single consumer thread Drain()s
+// everything pushed so far, in the order it was pushed (by each producer). Producers push onto an atomic singly-linked
+// stack and the consumer takes the whole stack in one exchange, so there is no ABA problem.
+template <class T>
+class VoidMPSCQueue {
+	private:
+		struct queue_node {
+			T value;
+			queue_node* next;
+		};
+		std::atomic<queue_node*> m_head{nullptr};
+		
+	public:
+		VoidMPSCQueue() {}
+		// A copy starts empty - anything already pushed belongs to the original's consumer.
+		VoidMPSCQueue(VoidMPSCQueue const&) {}
+		VoidMPSCQueue& operator=(VoidMPSCQueue const&) = delete;
+		~VoidMPSCQueue() {
+			Drain([](T&) {});
+		}
+		
+		void Push(T value) {
+			queue_node* new_node = new queue_node{std::move(value), m_head.load(std::memory_order_relaxed)};
+			while (!m_head.compare_exchange_weak(new_node->next, new_node, std::memory_order_release, std::memory_order_relaxed)) {
+			}
+		}
+		
+		bool Empty(void) const {
+			return (m_head.load(std::memory_order_acquire) == nullptr);
+		}
+		
+		template <class consumer_function>
+		void Drain(consumer_function consumer) {
+			queue_node* newest_node = m_head.exchange(nullptr, std::memory_order_acquire);
+			// The stack is newest first, reverse it to hand the values over oldest first.
+			queue_node* oldest_node = nullptr;
+			while (newest_node != nullptr) {
+				queue_node* next_node = newest_node->next;
+				newest_node->next = oldest_node;
+				oldest_node = newest_node;
+				newest_node = next_node;
+			}
+			while (oldest_node != nullptr) {
+				consumer(oldest_node->value);
+				queue_node* next_node = oldest_node->next;
+				delete oldest_node;
+				oldest_node = next_node;
+			}
+		}
+};
+
+// Reusable barrier for a fixed number of threads that meet many times in quick succession. Arriving threads spin
+// for a while before parking on a condition variable, so back-to-back meetings never pay the wakeup latency.
+class VoidSpinBarrier {
+	private:
+		int m_participant_count;
+		int m_spin_count;
+		std::atomic<int> m_arrived{0};
+		std::atomic<unsigned int> m_generation{0};
+		std::atomic<int> m_parked{0};
+		std::condition_variable m_park_condition;
+		std::mutex m_park_lock;
+		
+	public:
+		VoidSpinBarrier(int participant_count, int spin_count = 4096);
+		void ArriveAndWait(void);
+};
+
+// As VoidSpinBarrier, but only ever spins (yielding), so that it can be placed in memory shared between processes.
+class VoidSharedSpinBarrier {
+	private:
+		int m_participant_count;
+		std::atomic<int> m_arrived{0};
+		std::atomic<unsigned int> m_generation{0};
+		
+	public:
+		VoidSharedSpinBarrier(int participant_count);
+		void ArriveAndWait(void);
+};
+
+// Bounded lock-free single-producer single-consumer ring. The slots follow the ring in memory, so create one with
+// CreateAt() in at least RequiredBytes(capacity) of memory (which may be shared between processes, as the ring holds
+// no pointers). TryPush() fails when the ring is full and TryPop() when it is empty.
+template <class T>
+class alignas(64) VoidSPSCRing {
+	private:
+		alignas(64) std::atomic<uint64_t> m_head{0};	// Next slot to pop, only written by the consumer.
+		alignas(64) std::atomic<uint64_t> m_tail{0};	// Next slot to push, only written by the producer.
+		uint64_t m_capacity;
+		
+		explicit VoidSPSCRing(uint64_t capacity) : m_capacity(capacity) {}
+		T* Slots(void) {
+			return reinterpret_cast<T*>(this + 1);
+		}
+		
+	public:
+		static size_t RequiredBytes(uint64_t capacity) {
+			return sizeof(VoidSPSCRing) + (capacity * sizeof(T));
+		}
+		static VoidSPSCRing* CreateAt(void* memory, uint64_t capacity) {
+			return new (memory) VoidSPSCRing(capacity);
+		}
+		
+		bool TryPush(T const& value) {
+			uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			if ((tail - m_head.load(std::memory_order_acquire)) == m_capacity) {
+				return false;
+			}
+			Slots()[tail % m_capacity] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		
+		bool TryPop(T& value) {
+			uint64_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) {
+				return false;
+			}
+			value = Slots()[head % m_capacity];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+};
+
 #endif